@@ -1,7 +1,9 @@
 #include "alloc.h"
 
 #include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "objects.h"
 
@@ -20,3 +22,250 @@ Owl_Alloc owl_default_alloc_init() {
         .del = owl_default_del,
     };
 }
+
+// Every slab block starts with this header, chunks follow it
+struct Owl_SlabBlock {
+    size_t class_index;
+    size_t reserved;
+};
+
+typedef struct Owl_SlabBlock Owl_SlabBlock;
+
+#define OWL_SLAB_BLOCK_BASE(p) \
+    ((void *)((uintptr_t)(p) & ~((uintptr_t)OWL_SLAB_BLOCK_SIZE - 1)))
+
+static size_t owl_slab_find_block(const Owl_Slab *slab, const void *base) {
+    size_t lo = 0;
+    size_t hi = slab->block_length;
+    while (lo < hi) {
+        const size_t mid = lo + (hi - lo) / 2;
+        if ((uintptr_t)slab->blocks[mid] < (uintptr_t)base) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+static Owl_Boolean owl_slab_owns(const Owl_Slab *slab, const void *base) {
+    const size_t index = owl_slab_find_block(slab, base);
+    return (index < slab->block_length && slab->blocks[index] == base ? T : F);
+}
+
+static Owl_Boolean owl_slab_add_block(Owl_Slab *slab, const size_t class_index) {
+    if (slab->block_length >= slab->block_capacity) {
+        const size_t capacity = (slab->block_capacity == 0 ? 16 : slab->block_capacity * 2);
+        void **blocks = malloc(sizeof(void *) * capacity);
+        if (blocks == NULL) {
+            return F;
+        }
+        if (slab->blocks != NULL) {
+            memcpy(blocks, slab->blocks, sizeof(void *) * slab->block_length);
+            free(slab->blocks);
+        }
+        slab->blocks = blocks;
+        slab->block_capacity = capacity;
+    }
+
+    Owl_SlabBlock *block = aligned_alloc(OWL_SLAB_BLOCK_SIZE, OWL_SLAB_BLOCK_SIZE);
+    if (block == NULL) {
+        return F;
+    }
+    block->class_index = class_index;
+
+    const size_t index = owl_slab_find_block(slab, block);
+    memmove(slab->blocks + index + 1, slab->blocks + index, sizeof(void *) * (slab->block_length - index));
+    slab->blocks[index] = block;
+    slab->block_length++;
+    slab->stats.blocks++;
+
+    Owl_SlabClass *class = &slab->classes[class_index];
+    class->cursor = (char *)(block + 1);
+    class->limit = (char *)block + OWL_SLAB_BLOCK_SIZE;
+    return T;
+}
+
+static void *owl_slab_new(void *state, size_t size) {
+    Owl_Slab *slab = state;
+    if (size > OWL_SLAB_MAX_SIZE) {
+        void *ptr = malloc(size);
+        if (ptr != NULL) {
+            slab->stats.large_allocations++;
+        }
+        return ptr;
+    }
+    if (size == 0) {
+        size = 1;
+    }
+
+    const size_t class_index = (size - 1) / OWL_SLAB_GRANULE;
+    const size_t chunk_size = (class_index + 1) * OWL_SLAB_GRANULE;
+    Owl_SlabClass *class = &slab->classes[class_index];
+
+    void *ptr = class->free_list;
+    if (ptr != NULL) {
+        class->free_list = *(void **)ptr;
+    } else {
+        if (class->cursor == NULL || (size_t)(class->limit - class->cursor) < chunk_size) {
+            if (owl_slab_add_block(slab, class_index) == F) {
+                return NULL;
+            }
+        }
+        ptr = class->cursor;
+        class->cursor += chunk_size;
+    }
+
+    slab->stats.allocations++;
+    slab->stats.bytes_in_use += chunk_size;
+    return ptr;
+}
+
+static void owl_slab_del(void *state, void *ptr) {
+    if (ptr == NULL) return;
+    Owl_Slab *slab = state;
+
+    Owl_SlabBlock *block = OWL_SLAB_BLOCK_BASE(ptr);
+    if (owl_slab_owns(slab, block) == F) {
+        slab->stats.large_frees++;
+        free(ptr);
+        return;
+    }
+
+    Owl_SlabClass *class = &slab->classes[block->class_index];
+    *(void **)ptr = class->free_list;
+    class->free_list = ptr;
+
+    slab->stats.frees++;
+    slab->stats.bytes_in_use -= (block->class_index + 1) * OWL_SLAB_GRANULE;
+}
+
+Owl_Slab owl_slab_init(void) {
+    return (Owl_Slab){
+        .classes = {{0}},
+        .blocks = NULL,
+        .block_length = 0,
+        .block_capacity = 0,
+        .stats = {0},
+    };
+}
+
+void owl_slab_deinit(Owl_Slab *slab) {
+    for (size_t i = 0; i < slab->block_length; i++) {
+        free(slab->blocks[i]);
+    }
+    free(slab->blocks);
+    *slab = owl_slab_init();
+}
+
+Owl_Alloc owl_slab_alloc(Owl_Slab *slab) {
+    return (Owl_Alloc){
+        .state = slab,
+        .new = owl_slab_new,
+        .del = owl_slab_del,
+    };
+}
+
+Owl_SlabStats owl_slab_stats(const Owl_Slab *slab) {
+    return slab->stats;
+}
+
+#define OWL_ARENA_ALIGN(n) \
+    (((n) + (OWL_ARENA_ALIGNMENT - 1)) & ~(size_t)(OWL_ARENA_ALIGNMENT - 1))
+
+#define OWL_ARENA_HEADER_SIZE \
+    OWL_ARENA_ALIGN(sizeof(Owl_ArenaChunk))
+
+#define OWL_ARENA_CHUNK_DATA(c) \
+    ((char *)(c) + OWL_ARENA_HEADER_SIZE)
+
+static Owl_ArenaChunk *owl_arena_add_chunk(Owl_Arena *arena, const size_t size) {
+    Owl_ArenaChunk *chunk = NULL;
+    if (size <= OWL_ARENA_CHUNK_SIZE && arena->spare != NULL) {
+        chunk = arena->spare;
+        arena->spare = chunk->prev;
+    } else {
+        const size_t capacity = (size > OWL_ARENA_CHUNK_SIZE ? size : OWL_ARENA_CHUNK_SIZE);
+        chunk = OWL_NEW(arena->backing, OWL_ARENA_HEADER_SIZE + capacity);
+        if (chunk == NULL) {
+            return NULL;
+        }
+        chunk->capacity = capacity;
+    }
+    chunk->used = 0;
+    chunk->prev = arena->chunk;
+    arena->chunk = chunk;
+    return chunk;
+}
+
+static void *owl_arena_new(void *state, const size_t size) {
+    Owl_Arena *arena = state;
+    const size_t aligned = OWL_ARENA_ALIGN(size == 0 ? 1 : size);
+
+    Owl_ArenaChunk *chunk = arena->chunk;
+    if (chunk == NULL || chunk->capacity - chunk->used < aligned) {
+        chunk = owl_arena_add_chunk(arena, aligned);
+        if (chunk == NULL) {
+            return NULL;
+        }
+    }
+
+    void *ptr = OWL_ARENA_CHUNK_DATA(chunk) + chunk->used;
+    chunk->used += aligned;
+    return ptr;
+}
+
+static void owl_arena_del([[maybe_unused]] void *state, [[maybe_unused]] void *ptr) {
+}
+
+static void owl_arena_release(Owl_Arena *arena, Owl_ArenaChunk *chunk) {
+    if (chunk->capacity == OWL_ARENA_CHUNK_SIZE) {
+        chunk->prev = arena->spare;
+        arena->spare = chunk;
+    } else {
+        OWL_DEL(arena->backing, chunk);
+    }
+}
+
+Owl_Arena owl_arena_init(const Owl_Alloc backing) {
+    return (Owl_Arena){
+        .backing = backing,
+        .chunk = NULL,
+        .spare = NULL,
+    };
+}
+
+void owl_arena_deinit(Owl_Arena *arena) {
+    owl_arena_reset(arena, (Owl_ArenaMark){.chunk = NULL, .used = 0});
+    while (arena->spare != NULL) {
+        Owl_ArenaChunk *chunk = arena->spare;
+        arena->spare = chunk->prev;
+        OWL_DEL(arena->backing, chunk);
+    }
+}
+
+Owl_Alloc owl_arena_alloc(Owl_Arena *arena) {
+    return (Owl_Alloc){
+        .state = arena,
+        .new = owl_arena_new,
+        .del = owl_arena_del,
+    };
+}
+
+Owl_ArenaMark owl_arena_mark(const Owl_Arena *arena) {
+    return (Owl_ArenaMark){
+        .chunk = arena->chunk,
+        .used = (arena->chunk != NULL ? arena->chunk->used : 0),
+    };
+}
+
+void owl_arena_reset(Owl_Arena *arena, const Owl_ArenaMark mark) {
+    while (arena->chunk != mark.chunk) {
+        Owl_ArenaChunk *chunk = arena->chunk;
+        arena->chunk = chunk->prev;
+        owl_arena_release(arena, chunk);
+    }
+    if (arena->chunk != NULL) {
+        arena->chunk->used = mark.used;
+    }
+}
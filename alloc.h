@@ -20,4 +20,102 @@ alloc.new(alloc.state, (size))
 #define OWL_DEL(alloc, ptr) \
 alloc.del(alloc.state, (ptr))
 
+// Slab allocator: requests up to OWL_SLAB_MAX_SIZE are rounded up to a
+// multiple of OWL_SLAB_GRANULE and served from per-class free lists carved
+// out of OWL_SLAB_BLOCK_SIZE aligned blocks, larger requests go to malloc.
+#define OWL_SLAB_BLOCK_SIZE \
+    (64 * 1024)
+
+#define OWL_SLAB_GRANULE \
+    8
+
+#define OWL_SLAB_CLASS_COUNT \
+    32
+
+#define OWL_SLAB_MAX_SIZE \
+    (OWL_SLAB_GRANULE * OWL_SLAB_CLASS_COUNT)
+
+struct Owl_SlabStats {
+    size_t allocations;
+    size_t frees;
+    size_t bytes_in_use;
+    size_t blocks;
+    size_t large_allocations;
+    size_t large_frees;
+};
+
+typedef struct Owl_SlabStats Owl_SlabStats;
+
+struct Owl_SlabClass {
+    void *free_list;
+    char *cursor;
+    char *limit;
+};
+
+typedef struct Owl_SlabClass Owl_SlabClass;
+
+struct Owl_Slab {
+    Owl_SlabClass classes[OWL_SLAB_CLASS_COUNT];
+
+    // Sorted so del can tell slab memory from large allocations
+    void **blocks;
+    size_t block_length;
+    size_t block_capacity;
+
+    Owl_SlabStats stats;
+};
+
+typedef struct Owl_Slab Owl_Slab;
+
+Owl_Slab owl_slab_init(void);
+void owl_slab_deinit(Owl_Slab *slab);
+
+// The slab must outlive the returned allocator
+Owl_Alloc owl_slab_alloc(Owl_Slab *slab);
+
+Owl_SlabStats owl_slab_stats(const Owl_Slab *slab);
+
+// Arena allocator: bump allocates out of chunks taken from a backing
+// allocator, del is a no-op and memory is released by resetting to a mark.
+#define OWL_ARENA_CHUNK_SIZE \
+    (16 * 1024)
+
+#define OWL_ARENA_ALIGNMENT \
+    16
+
+struct Owl_ArenaChunk {
+    struct Owl_ArenaChunk *prev;
+    size_t capacity;
+    size_t used;
+};
+
+typedef struct Owl_ArenaChunk Owl_ArenaChunk;
+
+struct Owl_Arena {
+    Owl_Alloc backing;
+    Owl_ArenaChunk *chunk;
+    // Chunks released by a reset, kept around for the next pass
+    Owl_ArenaChunk *spare;
+};
+
+typedef struct Owl_Arena Owl_Arena;
+
+struct Owl_ArenaMark {
+    Owl_ArenaChunk *chunk;
+    size_t used;
+};
+
+typedef struct Owl_ArenaMark Owl_ArenaMark;
+
+Owl_Arena owl_arena_init(Owl_Alloc backing);
+void owl_arena_deinit(Owl_Arena *arena);
+
+// The arena must outlive the returned allocator
+Owl_Alloc owl_arena_alloc(Owl_Arena *arena);
+
+Owl_ArenaMark owl_arena_mark(const Owl_Arena *arena);
+
+// Frees everything allocated since the mark was taken
+void owl_arena_reset(Owl_Arena *arena, Owl_ArenaMark mark);
+
 #endif // OWL_ALLOC_H
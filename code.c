@@ -10,11 +10,40 @@ Owl_Code owl_code_init(const Owl_Alloc alloc) {
     code.capacity = OWL_CODE_CAPACITY;
     code.code = OWL_NEW(alloc, code.capacity * sizeof(Owl_Opcode));
     code.alloc = alloc;
+    code.gc = NULL;
     memset(code.code, 0, code.capacity * sizeof(Owl_Opcode));
     return code;
 }
 
+// The values an instruction pushes
+static int owl_opcode_constants(const Owl_Opcode *op, const Owl_Value **constants) {
+    switch (op->type) {
+    case OWL_OP_PUSH:
+        *constants = &op->value;
+        return 1;
+    case OWL_OP_PUSH_SYSCALL:
+        *constants = op->operands;
+        return 1;
+    case OWL_OP_PUSH2:
+    case OWL_OP_PUSH2_SYSCALL:
+        *constants = op->operands;
+        return 2;
+    default:
+        *constants = NULL;
+        return 0;
+    }
+}
+
 void owl_code_deinit(Owl_Code *code) {
+    for (size_t i = 0; i < code->length && code->gc != NULL; i++) {
+        const Owl_Value *constants;
+        const int count = owl_opcode_constants(&code->code[i], &constants);
+        for (int j = 0; j < count; j++) {
+            if (OWL_VALUE_IS_OBJECT(constants[j]) && !OWL_IS_PINNED(OWL_VALUE_AS_OBJECT(constants[j]))) {
+                owl_gc_remove_root(code->gc, OWL_VALUE_AS_OBJECT(constants[j]));
+            }
+        }
+    }
     OWL_DEL(code->alloc, code->code);
     code->length = 0;
     code->capacity = 0;
@@ -31,9 +60,9 @@ void owl_code_resize_if_needed(Owl_Code *code) {
     OWL_DEL(code->alloc, old_code);
 }
 
-void owl_code_push(Owl_Code *code, Owl_Object *op) {
+void owl_code_push(Owl_Code *code, const Owl_Value value) {
     owl_code_resize_if_needed(code);
-    code->code[code->length++] = OWL_PUSH_OP(op);
+    code->code[code->length++] = OWL_PUSH_OP(value);
 }
 
 void owl_code_syscall(Owl_Code *code, owl_intrinsic intrinsic, const char *intrinsic_name, int arg_count) {
@@ -41,37 +70,105 @@ void owl_code_syscall(Owl_Code *code, owl_intrinsic intrinsic, const char *intri
     code->code[code->length++] = OWL_SYSCALL_OP(intrinsic_name, intrinsic, arg_count);
 }
 
-Owl_String owl_code_tostr(Owl_Code *code) {
-    Owl_String result = owl_string_new(code->alloc);
+size_t owl_code_optimize(Owl_Code *code) {
+    size_t length = 0;
     for (size_t i = 0; i < code->length; i++) {
-        switch (code->code[i].type) {
+        const Owl_Opcode op = code->code[i];
+        Owl_Opcode *last = (length > 0 ? &code->code[length - 1] : NULL);
+        switch (op.type) {
         case OWL_OP_NONE:
-            owl_string_add_line_cstr(&result, "NOP", code->alloc);
+            continue;
+        case OWL_OP_PUSH:
+            if (last != NULL && last->type == OWL_OP_PUSH) {
+                const Owl_Value first = last->value;
+                *last = (Owl_Opcode){.type = OWL_OP_PUSH2, .operands = {first, op.value}};
+                continue;
+            }
+            break;
+        case OWL_OP_SYSCALL:
+            if (last != NULL && last->type == OWL_OP_PUSH) {
+                const Owl_Value first = last->value;
+                *last = op;
+                last->type = OWL_OP_PUSH_SYSCALL;
+                last->operands[0] = first;
+                continue;
+            }
+            if (last != NULL && last->type == OWL_OP_PUSH2) {
+                const Owl_Value first = last->operands[0];
+                const Owl_Value second = last->operands[1];
+                *last = op;
+                last->type = OWL_OP_PUSH2_SYSCALL;
+                last->operands[0] = first;
+                last->operands[1] = second;
+                continue;
+            }
+            break;
+        default:
+            break;
+        }
+        code->code[length++] = op;
+    }
+    const size_t removed = code->length - length;
+    code->length = length;
+    return removed;
+}
+
+static void owl_code_write_syscall(Owl_Writer *writer, const Owl_Opcode *op) {
+    owl_writer_write_cstr(writer, op->intrinsic_name ? op->intrinsic_name : "<intrinsic>");
+    char buf[32];
+    const int length = snprintf(buf, sizeof(buf), " argc=%d\n", op->intrinsic_arg_count);
+    owl_writer_write(writer, buf, (size_t)length);
+}
+
+void owl_code_write(Owl_Writer *writer, const Owl_Code *code) {
+    for (size_t i = 0; i < code->length; i++) {
+        const Owl_Opcode *op = &code->code[i];
+        switch (op->type) {
+        case OWL_OP_NONE:
+            owl_writer_write_cstr(writer, "NOP\n");
             break;
         case OWL_OP_JUMP:
-            owl_string_add_line_cstr(&result, "JUMP", code->alloc);
+            owl_writer_write_cstr(writer, "JUMP\n");
             break;
         case OWL_OP_PUSH:
-            Owl_String push_value = owl_object_tostring(code->code[i].value, code->alloc);
-            Owl_String push_line = owl_string_new(code->alloc);
-            owl_string_append_cstr(&push_line, "PUSH ", code->alloc);
-            owl_string_append(&push_line, push_value, code->alloc);
-            owl_string_add_line(&result, push_line, code->alloc);
-            owl_string_del(&push_line, code->alloc);
-            owl_string_del(&push_value, code->alloc);
+            owl_writer_write_cstr(writer, "PUSH ");
+            owl_value_write(writer, op->value);
+            owl_writer_write_cstr(writer, "\n");
             break;
         case OWL_OP_SYSCALL:
-            Owl_String sys = owl_string_new(code->alloc);
-            owl_string_append_cstr(&sys, "SYSCALL ", code->alloc);
-            const char *intr_name = code->code[i].intrinsic_name ? code->code[i].intrinsic_name : "<intrinsic>";
-            owl_string_append_cstr(&sys, intr_name, code->alloc);
-            char buf[32];
-            snprintf(buf, sizeof(buf), " argc=%d", code->code[i].intrinsic_arg_count);
-            owl_string_append_cstr(&sys, buf, code->alloc);
-            owl_string_add_line(&result, sys, code->alloc);
-            owl_string_del(&sys, code->alloc);
+            owl_writer_write_cstr(writer, "SYSCALL ");
+            owl_code_write_syscall(writer, op);
+            break;
+        case OWL_OP_PUSH2:
+            owl_writer_write_cstr(writer, "PUSH2 ");
+            owl_value_write(writer, op->operands[0]);
+            owl_writer_write_cstr(writer, " ");
+            owl_value_write(writer, op->operands[1]);
+            owl_writer_write_cstr(writer, "\n");
+            break;
+        case OWL_OP_PUSH_SYSCALL:
+            owl_writer_write_cstr(writer, "PUSH_SYSCALL ");
+            owl_value_write(writer, op->operands[0]);
+            owl_writer_write_cstr(writer, " ");
+            owl_code_write_syscall(writer, op);
+            break;
+        case OWL_OP_PUSH2_SYSCALL:
+            owl_writer_write_cstr(writer, "PUSH2_SYSCALL ");
+            owl_value_write(writer, op->operands[0]);
+            owl_writer_write_cstr(writer, " ");
+            owl_value_write(writer, op->operands[1]);
+            owl_writer_write_cstr(writer, " ");
+            owl_code_write_syscall(writer, op);
             break;
         }
     }
-    return result;
+}
+
+Owl_String owl_code_tostr(Owl_Code *code) {
+    char buffer[OWL_WRITER_BUFFER / 16];
+    Owl_StringSink target = {.string = owl_string_new(code->alloc), .alloc = code->alloc};
+    Owl_Writer writer = owl_writer_init(owl_string_sink(&target), buffer, sizeof(buffer), code->alloc);
+    owl_code_write(&writer, code);
+    owl_writer_flush(&writer);
+    return target.string;
 }
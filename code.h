@@ -8,7 +8,12 @@ enum Owl_OpcodeType {
     OWL_OP_NONE = 0,
     OWL_OP_JUMP = 1,
     OWL_OP_PUSH = 2,
-    OWL_OP_SYSCALL = 3
+    OWL_OP_SYSCALL = 3,
+    // Superinstructions made by owl_code_optimize, pushing their operands
+    // in order before doing what the plain op would
+    OWL_OP_PUSH2 = 4,
+    OWL_OP_PUSH_SYSCALL = 5,
+    OWL_OP_PUSH2_SYSCALL = 6
 };
 
 typedef enum Owl_OpcodeType Owl_OpcodeType;
@@ -21,7 +26,7 @@ struct Owl_Opcode {
     Owl_OpcodeType type;
     const char *intrinsic_name;
     union {
-        Owl_Object *value;
+        Owl_Value value;
         struct {
             Owl_Object *call;
             int arg_count;
@@ -31,6 +36,7 @@ struct Owl_Opcode {
             int intrinsic_arg_count;
         };
     };
+    Owl_Value operands[2];
 };
 
 typedef struct Owl_Opcode Owl_Opcode;
@@ -38,6 +44,8 @@ typedef struct Owl_Opcode Owl_Opcode;
 struct Owl_Code {
     Owl_Opcode *code;
     Owl_Alloc alloc;
+    // Set when pushed objects were registered as roots, deinit drops them
+    Owl_GC *gc;
     size_t length;
     size_t capacity;
 };
@@ -58,10 +66,18 @@ void owl_code_deinit(Owl_Code *code);
 
 void owl_code_resize_if_needed(Owl_Code *code);
 
-void owl_code_push(Owl_Code *code, Owl_Object *op);
+void owl_code_push(Owl_Code *code, Owl_Value value);
 
 void owl_code_syscall(Owl_Code *code, owl_intrinsic intrinsic, const char *intrinsic_name, int arg_count);
 
+// Rewrites the code in place: drops NOPs, pairs up consecutive pushes and
+// folds the pushes right before a call into the call. Returns the number
+// of instructions removed.
+size_t owl_code_optimize(Owl_Code *code);
+
+// One instruction per line
+void owl_code_write(Owl_Writer *writer, const Owl_Code *code);
+
 Owl_String owl_code_tostr(Owl_Code *code);
 
 #endif //OWL_CODE_H
@@ -0,0 +1,174 @@
+#include "dict.h"
+#include "rope.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static uint32_t owl_dict_hash(const Owl_Object *key) {
+    if (key == NULL) return 0;
+    switch (OWL_TYPE(key)) {
+        case OWL_SYMBOL:
+            return key->symbol.hash;
+        case OWL_NUMBER: {
+            // 0.0 and -0.0 are the same key, and so is every NaN
+            double number = (key->number == 0.0 ? 0.0 : key->number);
+            if (number != number) {
+                number = __builtin_nan("");
+            }
+            uint64_t bits;
+            memcpy(&bits, &number, sizeof(bits));
+            bits ^= bits >> 33;
+            bits *= 0xff51afd7ed558ccdu;
+            bits ^= bits >> 33;
+            return (uint32_t)bits;
+        }
+        case OWL_STRING:
+            return owl_string_hash(owl_string_data(&key->string), key->string.length);
+        case OWL_BOOLEAN:
+            return (key->boolean == T ? 1u : 2u);
+        default:
+            return (OWL_GC_IDENTITY_HASH(key) ^ ((uint32_t)OWL_TYPE(key) << 12)) * 0x9e3779b9u;
+    }
+}
+
+static Owl_Boolean owl_dict_equal(const Owl_Object *a, const Owl_Object *b) {
+    if (a == b) return T;
+    if (a == NULL || b == NULL || OWL_TYPE(a) != OWL_TYPE(b)) return F;
+    switch (OWL_TYPE(a)) {
+        case OWL_NUMBER:
+            return (a->number == b->number || (a->number != a->number && b->number != b->number) ? T : F);
+        case OWL_STRING:
+            return (a->string.length == b->string.length && memcmp(owl_string_data(&a->string), owl_string_data(&b->string), a->string.length) == 0 ? T : F);
+        case OWL_BOOLEAN:
+            return (a->boolean == b->boolean ? T : F);
+        case OWL_NOTHING:
+            return T;
+        default:
+            return F;
+    }
+}
+
+static size_t owl_dict_find(const Owl_Object *dict, const Owl_Object *key, const uint32_t hash) {
+    if (dict->dict_length == 0) return SIZE_MAX;
+    const size_t mask = dict->dict_capacity - 1;
+    size_t index = hash & mask;
+    // An entry further from home than the slot being looked at would have
+    // taken that slot, so the search stops there
+    for (uint32_t distance = 1;; distance++) {
+        const Owl_DictSlot *slot = &dict->dict_slots[index];
+        if (slot->distance < distance) return SIZE_MAX;
+        if (slot->hash == hash && owl_dict_equal(slot->key, key) == T) return index;
+        index = (index + 1) & mask;
+    }
+}
+
+// The key must not be in the table and there must be a free slot
+static void owl_dict_insert(Owl_DictSlot *slots, const size_t capacity, Owl_DictSlot entry) {
+    const size_t mask = capacity - 1;
+    size_t index = entry.hash & mask;
+    entry.distance = 1;
+    for (;;) {
+        Owl_DictSlot *slot = &slots[index];
+        if (slot->distance == 0) {
+            *slot = entry;
+            return;
+        }
+        // Entries closer to home give their slot up to poorer ones
+        if (slot->distance < entry.distance) {
+            const Owl_DictSlot displaced = *slot;
+            *slot = entry;
+            entry = displaced;
+        }
+        index = (index + 1) & mask;
+        entry.distance++;
+    }
+}
+
+static void owl_dict_resize(Owl_GC *gc, Owl_Object *dict, const size_t capacity) {
+    Owl_DictSlot *slots = OWL_NEW(gc->alloc, sizeof(Owl_DictSlot) * capacity);
+    if (slots == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+    memset(slots, 0, sizeof(Owl_DictSlot) * capacity);
+    for (size_t i = 0; i < dict->dict_capacity; i++) {
+        if (dict->dict_slots[i].distance != 0) {
+            owl_dict_insert(slots, capacity, dict->dict_slots[i]);
+        }
+    }
+    if (dict->dict_slots != NULL) {
+        OWL_DEL(gc->alloc, dict->dict_slots);
+    }
+    dict->dict_slots = slots;
+    dict->dict_capacity = capacity;
+}
+
+Owl_Object *owl_new_dict(Owl_GC *gc, const size_t capacity) {
+    Owl_Object *dict = owl_gc_new(gc, OWL_DICT);
+    dict->dict_slots = NULL;
+    dict->dict_length = 0;
+    dict->dict_capacity = 0;
+    if (capacity > 0) {
+        size_t slots = OWL_DICT_CAPACITY;
+        while (slots * OWL_DICT_MAX_LOAD < capacity * 8) {
+            slots *= 2;
+        }
+        owl_dict_resize(gc, dict, slots);
+    }
+    return dict;
+}
+
+Owl_Object *owl_dict_get(Owl_GC *gc, const Owl_Object *dict, Owl_Object *key) {
+    key = owl_rope_flatten(gc, key);
+    const size_t index = owl_dict_find(dict, key, owl_dict_hash(key));
+    return (index != SIZE_MAX ? dict->dict_slots[index].value : NULL);
+}
+
+void owl_dict_set(Owl_GC *gc, Owl_Object *dict, Owl_Object *key, Owl_Object *value) {
+    key = owl_rope_flatten(gc, key);
+    const uint32_t hash = owl_dict_hash(key);
+    const size_t index = owl_dict_find(dict, key, hash);
+    if (index != SIZE_MAX) {
+        dict->dict_slots[index].value = value;
+    } else {
+        if ((dict->dict_length + 1) * 8 > dict->dict_capacity * OWL_DICT_MAX_LOAD) {
+            owl_dict_resize(gc, dict, (dict->dict_capacity == 0 ? OWL_DICT_CAPACITY : dict->dict_capacity * 2));
+        }
+        owl_dict_insert(dict->dict_slots, dict->dict_capacity, (Owl_DictSlot){.key = key, .value = value, .hash = hash});
+        dict->dict_length++;
+        owl_gc_write_barrier(gc, dict, key);
+    }
+    owl_gc_write_barrier(gc, dict, value);
+}
+
+Owl_Boolean owl_dict_remove(Owl_GC *gc, Owl_Object *dict, Owl_Object *key) {
+    key = owl_rope_flatten(gc, key);
+    size_t index = owl_dict_find(dict, key, owl_dict_hash(key));
+    if (index == SIZE_MAX) return F;
+
+    // Shift the rest of the run back a slot instead of leaving a tombstone
+    const size_t mask = dict->dict_capacity - 1;
+    size_t next = (index + 1) & mask;
+    while (dict->dict_slots[next].distance > 1) {
+        dict->dict_slots[index] = dict->dict_slots[next];
+        dict->dict_slots[index].distance--;
+        index = next;
+        next = (next + 1) & mask;
+    }
+    dict->dict_slots[index] = (Owl_DictSlot){0};
+    dict->dict_length--;
+    return T;
+}
+
+Owl_Boolean owl_dict_next(const Owl_Object *dict, size_t *cursor, Owl_Object **key, Owl_Object **value) {
+    while (*cursor < dict->dict_capacity) {
+        const Owl_DictSlot *slot = &dict->dict_slots[(*cursor)++];
+        if (slot->distance != 0) {
+            *key = slot->key;
+            *value = slot->value;
+            return T;
+        }
+    }
+    return F;
+}
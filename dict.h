@@ -0,0 +1,34 @@
+#ifndef OWL_DICT_H
+#define OWL_DICT_H
+
+#include "gc.h"
+
+// Slots allocated by the first insert into an empty dict
+#define OWL_DICT_CAPACITY \
+    8
+
+// The slot array doubles once it would be more than this many eighths full
+#define OWL_DICT_MAX_LOAD \
+    7
+
+// Symbols, numbers, strings, booleans and nothing are compared by value,
+// with every NaN being the same key. Other objects are compared by
+// identity, since they can move they hash by the identity hash in their
+// header rather than by address. Ropes are keyed as the strings they
+// spell, they're flattened on the way in, which is why lookups take the
+// GC as well.
+Owl_Object *owl_new_dict(Owl_GC *gc, size_t capacity);
+
+// Returns NULL when the key isn't there
+Owl_Object *owl_dict_get(Owl_GC *gc, const Owl_Object *dict, Owl_Object *key);
+
+// Inserts or replaces, applies the write barrier
+void owl_dict_set(Owl_GC *gc, Owl_Object *dict, Owl_Object *key, Owl_Object *value);
+
+Owl_Boolean owl_dict_remove(Owl_GC *gc, Owl_Object *dict, Owl_Object *key);
+
+// Walks the entries in slot order, starting with *cursor at zero. Returns
+// F once every entry has been seen. The dict must not change meanwhile.
+Owl_Boolean owl_dict_next(const Owl_Object *dict, size_t *cursor, Owl_Object **key, Owl_Object **value);
+
+#endif //OWL_DICT_H
@@ -8,43 +8,97 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 
-void owl_add_intrinsic(Owl_Evaluator *eval, owl_intrinsic intrinsic, const char *sym) {
-    if (eval->intrinsics.fns == NULL) {
-        eval->intrinsics.fns = OWL_NEW(eval->gc->alloc, sizeof(Owl_NamedIntrinsic) * OWL_INTRINSIC_LENGTH);
-        eval->intrinsics.capacity = OWL_INTRINSIC_LENGTH;
-        eval->intrinsics.length = 1;
-        eval->intrinsics.fns[0] = (Owl_NamedIntrinsic){.fn = intrinsic, .sym = sym,};
+static void owl_intrinsics_reserve(Owl_Evaluator *eval, const size_t count) {
+    if (eval->intrinsics.length + count <= eval->intrinsics.capacity) {
         return;
     }
-    if (eval->intrinsics.length >= eval->intrinsics.capacity) {
-        eval->intrinsics.capacity += OWL_INTRINSIC_LENGTH;
-        Owl_NamedIntrinsic *old_fns = eval->intrinsics.fns;
-        eval->intrinsics.fns = malloc(eval->intrinsics.capacity * sizeof(Owl_NamedIntrinsic));
-        for (size_t i = 0; i < eval->intrinsics.length; i++) {
-            eval->intrinsics.fns[i] = old_fns[i];
+    size_t capacity = (eval->intrinsics.capacity == 0 ? OWL_INTRINSIC_LENGTH : eval->intrinsics.capacity);
+    while (capacity < eval->intrinsics.length + count) {
+        capacity *= 2;
+    }
+    Owl_NamedIntrinsic *fns = OWL_NEW(eval->gc->alloc, capacity * sizeof(Owl_NamedIntrinsic));
+    if (fns == NULL) {
+        fprintf(stderr, "Failed to allocate intrinsics\n");
+        exit(1);
+    }
+    if (eval->intrinsics.fns != NULL) {
+        memcpy(fns, eval->intrinsics.fns, eval->intrinsics.length * sizeof(Owl_NamedIntrinsic));
+        OWL_DEL(eval->gc->alloc, eval->intrinsics.fns);
+    }
+    eval->intrinsics.fns = fns;
+    eval->intrinsics.capacity = capacity;
+}
+
+static void owl_intrinsics_index(Owl_Evaluator *eval, const uint32_t id, const size_t position) {
+    if (id >= eval->intrinsics.by_id_length) {
+        size_t length = (eval->intrinsics.by_id_length == 0 ? OWL_INTRINSIC_LENGTH : eval->intrinsics.by_id_length);
+        while (length <= id) {
+            length *= 2;
+        }
+        uint32_t *by_id = OWL_NEW(eval->gc->alloc, length * sizeof(uint32_t));
+        if (by_id == NULL) {
+            fprintf(stderr, "Failed to allocate intrinsics\n");
+            exit(1);
         }
-        OWL_DEL(eval->gc->alloc, old_fns);
+        memset(by_id, 0, length * sizeof(uint32_t));
+        if (eval->intrinsics.by_id != NULL) {
+            memcpy(by_id, eval->intrinsics.by_id, eval->intrinsics.by_id_length * sizeof(uint32_t));
+            OWL_DEL(eval->gc->alloc, eval->intrinsics.by_id);
+        }
+        eval->intrinsics.by_id = by_id;
+        eval->intrinsics.by_id_length = length;
+    }
+    eval->intrinsics.by_id[id] = (uint32_t)(position + 1);
+}
+
+static void owl_intrinsics_insert(Owl_Evaluator *eval, const owl_intrinsic intrinsic, const char *sym, const Owl_Boolean pure) {
+    Owl_Object *symbol = owl_new_symbol(eval->gc, sym);
+    const uint32_t id = symbol->symbol.id;
+
+    // Registering a name again replaces the previous intrinsic
+    if (id < eval->intrinsics.by_id_length && eval->intrinsics.by_id[id] != 0) {
+        Owl_NamedIntrinsic *entry = &eval->intrinsics.fns[eval->intrinsics.by_id[id] - 1];
+        entry->fn = intrinsic;
+        entry->pure = pure;
+        return;
     }
-    eval->intrinsics.fns[eval->intrinsics.length++] = (Owl_NamedIntrinsic){
-        .sym = sym,
+
+    const size_t position = eval->intrinsics.length++;
+    eval->intrinsics.fns[position] = (Owl_NamedIntrinsic){
+        .sym = symbol->symbol.data,
+        .symbol = symbol,
         .fn = intrinsic,
+        .pure = pure,
     };
+    owl_intrinsics_index(eval, id, position);
 }
 
-void owl_load_intrinsics(Owl_Evaluator *eval) {
-    for (size_t i = 0; i < sizeof(owl_base_intrinsics) / sizeof(owl_base_intrinsics[0]); i++) {
-        owl_add_intrinsic(eval, owl_base_intrinsics[i].fn, owl_base_intrinsics[i].sym);
+void owl_add_intrinsic(Owl_Evaluator *eval, owl_intrinsic intrinsic, const char *sym) {
+    owl_intrinsics_reserve(eval, 1);
+    owl_intrinsics_insert(eval, intrinsic, sym, F);
+}
+
+void owl_add_intrinsics(Owl_Evaluator *eval, const Owl_NamedIntrinsic *intrinsics, const size_t count) {
+    owl_intrinsics_reserve(eval, count);
+    for (size_t i = 0; i < count; i++) {
+        owl_intrinsics_insert(eval, intrinsics[i].fn, intrinsics[i].sym, intrinsics[i].pure);
     }
 }
 
+void owl_load_intrinsics(Owl_Evaluator *eval) {
+    owl_add_intrinsics(eval, owl_base_intrinsics, owl_base_intrinsics_length);
+}
+
 Owl_Evaluator owl_eval_init(Owl_GC *gc) {
     Owl_Evaluator eval = (Owl_Evaluator){
         .gc = gc,
         .pc = 0,
         .stack = {0},
-        .intrinsics = {.fns = NULL, .length = 0, .capacity = 0}
+        .do_symbol = owl_new_symbol(gc, "do"),
+        .intrinsics = {.fns = NULL, .length = 0, .capacity = 0, .by_id = NULL, .by_id_length = 0}
     };
 
     owl_load_intrinsics(&eval);
@@ -57,17 +111,70 @@ void owl_eval_deinit(Owl_Evaluator *eval) {
         OWL_DEL(eval->gc->alloc, eval->intrinsics.fns);
         eval->intrinsics.fns = NULL;
     }
+    if (eval->intrinsics.by_id != NULL) {
+        OWL_DEL(eval->gc->alloc, eval->intrinsics.by_id);
+        eval->intrinsics.by_id = NULL;
+    }
     eval->intrinsics.length = 0;
     eval->intrinsics.capacity = 0;
+    eval->intrinsics.by_id_length = 0;
+    if (eval->stack.data != NULL) {
+        OWL_DEL(eval->gc->alloc, eval->stack.data);
+    }
+    eval->stack = (Owl_Stack){0};
+}
+
+const Owl_NamedIntrinsic *owl_find_intrinsic(Owl_Evaluator *eval, const Owl_Object *symbol) {
+    if (symbol == NULL || OWL_TYPE(symbol) != OWL_SYMBOL) {
+        return NULL;
+    }
+    const uint32_t id = symbol->symbol.id;
+    if (id >= eval->intrinsics.by_id_length || eval->intrinsics.by_id[id] == 0) {
+        return NULL;
+    }
+    return &eval->intrinsics.fns[eval->intrinsics.by_id[id] - 1];
+}
+
+owl_intrinsic owl_get_intrinsic(Owl_Evaluator *eval, const Owl_Object *symbol) {
+    const Owl_NamedIntrinsic *entry = owl_find_intrinsic(eval, symbol);
+    return (entry != NULL ? entry->fn : NULL);
+}
+
+// Objects referenced from the code are kept alive and in place by rooting
+// them until owl_code_deinit, pinned ones such as symbols need no root
+static void owl_compile_value(Owl_Evaluator *eval, Owl_Code *code, const Owl_Value value) {
+    if (OWL_VALUE_IS_OBJECT(value) && !OWL_IS_PINNED(OWL_VALUE_AS_OBJECT(value))) {
+        owl_gc_add_root(eval->gc, OWL_VALUE_AS_OBJECT(value));
+    }
+    owl_code_push(code, value);
 }
 
-owl_intrinsic owl_get_intrinsic(Owl_Evaluator *eval, const char *sym) {
-    for (size_t i = 0; i < eval->intrinsics.length; i++) {
-        if (strcmp(eval->intrinsics.fns[i].sym, sym) == 0) {
-            return eval->intrinsics.fns[i].fn;
+static void owl_compile_constant(Owl_Evaluator *eval, Owl_Code *code, Owl_Object *object) {
+    owl_compile_value(eval, code, owl_value_from_object(object));
+}
+
+// Evaluates a call to a pure intrinsic when every argument is a number
+// literal. Anything else, nested calls included, is left to run time, so
+// folded code does what the unfolded code would and a call that fails
+// on its arguments still fails when it runs.
+static Owl_Boolean owl_compile_fold(Owl_Evaluator *eval, const Owl_NamedIntrinsic *entry, const Owl_Object *call, Owl_Value *result) {
+    OWL_EACH(it, call->next) {
+        if (OWL_TYPE(it->value) != OWL_NUMBER) {
+            return F;
         }
     }
-    return NULL;
+    Owl_Alloc alloc = eval->gc->alloc;
+    Owl_Stack args = {0};
+    OWL_EACH(it, call->next) {
+        owl_stack_push(&args, owl_value_from_object(it->value), alloc);
+    }
+    const size_t count = args.length;
+    entry->fn(eval->gc, &args);
+    *result = (args.length > count ? args.data[args.length - 1] : OWL_VALUE_NOTHING);
+    if (args.data != NULL) {
+        OWL_DEL(alloc, args.data);
+    }
+    return T;
 }
 
 void owl_compile_list(Owl_Evaluator *eval, Owl_Code *code, Owl_Object *object) {
@@ -75,19 +182,26 @@ void owl_compile_list(Owl_Evaluator *eval, Owl_Code *code, Owl_Object *object) {
         return;
     }
 
-    owl_intrinsic intr = owl_get_intrinsic(eval, object->value->symbol.data);
-    if (intr != NULL) {
-        int arg_count = 0;
-        OWL_EACH(it, object->next) {
-            owl_code_push(code, it->value);
-            arg_count++;
-        }
-        owl_code_syscall(code, intr, object->value->symbol.data, arg_count);
+    const Owl_NamedIntrinsic *entry = owl_find_intrinsic(eval, object->value);
+    if (entry == NULL) {
+        return;
+    }
+    Owl_Value folded;
+    if (entry->pure == T && owl_compile_fold(eval, entry, object, &folded) == T) {
+        owl_compile_value(eval, code, folded);
+        return;
+    }
+
+    int arg_count = 0;
+    OWL_EACH(it, object->next) {
+        owl_compile_constant(eval, code, it->value);
+        arg_count++;
     }
+    owl_code_syscall(code, entry->fn, object->value->symbol.data, arg_count);
 }
 
 void owl_compile_object(Owl_Evaluator *eval, Owl_Code *code, Owl_Object *object) {
-    switch (object->type) {
+    switch (OWL_TYPE(object)) {
         case OWL_NOTHING:
         case OWL_NUMBER:
         case OWL_BOOLEAN:
@@ -97,14 +211,21 @@ void owl_compile_object(Owl_Evaluator *eval, Owl_Code *code, Owl_Object *object)
             owl_compile_list(eval, code, object);
         case OWL_ARRAY:
         case OWL_DICT:
+        case OWL_F64_ARRAY:
+        case OWL_ROPE:
             break;
     }
 }
 
 Owl_Code owl_compile(Owl_Evaluator *eval, const Owl_Object *script) {
-    Owl_Code code = owl_code_init(eval->gc->alloc);
+    return owl_compile_with(eval, script, eval->gc->alloc);
+}
 
-    if (script->type != OWL_LIST || !owl_check_symbol(script->value, "do")) {
+Owl_Code owl_compile_with(Owl_Evaluator *eval, const Owl_Object *script, const Owl_Alloc alloc) {
+    Owl_Code code = owl_code_init(alloc);
+    code.gc = eval->gc;
+
+    if (OWL_TYPE(script) != OWL_LIST || !owl_check_symbol(script->value, eval->do_symbol)) {
         fprintf(stderr, "Expected 'do'\n");
         exit(1);
     }
@@ -118,75 +239,202 @@ Owl_Code owl_compile(Owl_Evaluator *eval, const Owl_Object *script) {
     return code;
 }
 
-Owl_Boolean end_of_program(Owl_Evaluator *eval, Owl_Code code) {
-    return (eval->pc >= code.length);
+static void owl_eval_scan(Owl_GC *gc, void *context) {
+    Owl_Evaluator *eval = context;
+    for (size_t i = 0; i < eval->stack.length; i++) {
+        owl_gc_visit(gc, &eval->stack.data[i]);
+    }
 }
 
-Owl_Opcode owl_eval_get_current_opcode(Owl_Evaluator *eval, const Owl_Code code) {
-    return code.code[eval->pc];
-}
+// GCC and Clang can jump from the end of each handler straight to the next
+// one through a table of label addresses, so every handler gets its own
+// indirect branch to predict instead of all of them sharing the switch's.
+// Define OWL_EVAL_SWITCH to build the portable loop instead.
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(OWL_EVAL_SWITCH)
+#define OWL_EVAL_THREADED 1
+#endif
+
+#ifdef OWL_EVAL_THREADED
+#define OWL_EVAL_CASE(label, type) \
+    label:
+#define OWL_EVAL_DISPATCH() \
+    do { \
+        if (op == end) goto done; \
+        goto *handlers[op->type]; \
+    } while (0)
+#define OWL_EVAL_NEXT() \
+    do { \
+        op++; \
+        OWL_EVAL_DISPATCH(); \
+    } while (0)
+#else
+#define OWL_EVAL_CASE(label, type) \
+    case type:
+// The loop steps op
+#define OWL_EVAL_NEXT() \
+    continue
+#endif
+
+// Makes room for n more values on the cached stack
+#define OWL_EVAL_RESERVE(n) \
+    do { \
+        if (length + (n) > capacity) { \
+            stack->length = length; \
+            owl_stack_reserve(stack, (n), gc->alloc); \
+            data = stack->data; \
+            capacity = stack->capacity; \
+        } \
+    } while (0)
+
+#ifdef OWL_EVAL_THREADED
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+#endif
+
+Owl_Value owl_eval_code(Owl_Evaluator *eval, const Owl_Code code) {
+    Owl_GC *gc = eval->gc;
+    Owl_Stack *stack = &eval->stack;
+    owl_gc_add_scanner(gc, owl_eval_scan, eval);
+
+    const Owl_Opcode *op = code.code + (eval->pc < code.length ? eval->pc : code.length);
+    const Owl_Opcode *const end = code.code + code.length;
+
+    // The stack is kept in locals between instructions and written back
+    // before anything that looks at it, the scanner or an intrinsic
+    Owl_Value *data = stack->data;
+    size_t length = stack->length;
+    size_t capacity = stack->capacity;
+
+#ifdef OWL_EVAL_THREADED
+    static void *const handlers[] = {
+        [OWL_OP_NONE] = &&owl_op_none,
+        [OWL_OP_JUMP] = &&owl_op_jump,
+        [OWL_OP_PUSH] = &&owl_op_push,
+        [OWL_OP_SYSCALL] = &&owl_op_syscall,
+        [OWL_OP_PUSH2] = &&owl_op_push2,
+        [OWL_OP_PUSH_SYSCALL] = &&owl_op_push_syscall,
+        [OWL_OP_PUSH2_SYSCALL] = &&owl_op_push2_syscall,
+    };
+    OWL_EVAL_DISPATCH();
+#else
+    for (;; op++) {
+        if (op == end) goto done;
+        switch (op->type) {
+#endif
+
+    OWL_EVAL_CASE(owl_op_none, OWL_OP_NONE)
+    OWL_EVAL_CASE(owl_op_jump, OWL_OP_JUMP)
+        OWL_EVAL_NEXT();
+
+    OWL_EVAL_CASE(owl_op_push, OWL_OP_PUSH)
+        OWL_EVAL_RESERVE(1);
+        data[length++] = op->value;
+        OWL_EVAL_NEXT();
+
+    OWL_EVAL_CASE(owl_op_push2, OWL_OP_PUSH2)
+        OWL_EVAL_RESERVE(2);
+        data[length++] = op->operands[0];
+        data[length++] = op->operands[1];
+        OWL_EVAL_NEXT();
+
+    OWL_EVAL_CASE(owl_op_push_syscall, OWL_OP_PUSH_SYSCALL)
+        OWL_EVAL_RESERVE(1);
+        data[length++] = op->operands[0];
+        goto call;
+
+    OWL_EVAL_CASE(owl_op_push2_syscall, OWL_OP_PUSH2_SYSCALL)
+        OWL_EVAL_RESERVE(2);
+        data[length++] = op->operands[0];
+        data[length++] = op->operands[1];
+        goto call;
+
+    OWL_EVAL_CASE(owl_op_syscall, OWL_OP_SYSCALL)
+    call: {
+        // Everything live is on the stack or rooted between instructions
+        stack->length = length;
+        owl_gc_safepoint(gc);
+
+        if ((size_t)op->intrinsic_arg_count > length) {
+            fprintf(stderr, "stack underflow\n");
+            exit(1);
+        }
 
-Owl_Object *owl_eval_code(Owl_Evaluator *eval, const Owl_Code code) {
-    while (!end_of_program(eval, code)) {
-        Owl_Opcode op = owl_eval_get_current_opcode(eval, code);
-        switch (op.type) {
-        case OWL_OP_NONE:
-            break;
-        case OWL_OP_JUMP:
-            break;
-        case OWL_OP_PUSH:
-            owl_stack_push(&eval->stack, op.value, eval->gc->alloc);
-            break;
-        case OWL_OP_SYSCALL: {
-            owl_intrinsic intr = op.intrinsic;
-
-            if ((size_t)op.intrinsic_arg_count > eval->stack.length) {
-                fprintf(stderr, "stack underflow\n");
-                exit(1);
-            }
-
-            size_t start = eval->stack.length - op.intrinsic_arg_count;
-            Owl_Stack stack = (Owl_Stack){
-                .length = op.intrinsic_arg_count,
-                .capacity = eval->stack.capacity - start,
-                .data = eval->stack.data + start
-            };
-            intr(eval->gc, &stack);
-
-            eval->stack.length = start + stack.length;
-            if (start == 0) {
-                eval->stack.data = stack.data;
-                eval->stack.capacity = stack.capacity;
-            }
+        // The intrinsic sees its arguments as a stack of their own. There
+        // is always room for the result, growing the view would free memory
+        // from the middle of the evaluator's stack.
+        if (length == stack->capacity) {
+            owl_stack_reserve(stack, 1, gc->alloc);
         }
+        const size_t start = length - op->intrinsic_arg_count;
+        Owl_Stack args = (Owl_Stack){
+            .length = op->intrinsic_arg_count,
+            .capacity = stack->capacity - start,
+            .data = stack->data + start
+        };
+        op->intrinsic(gc, &args);
+
+        if (start == 0) {
+            stack->data = args.data;
+            stack->capacity = args.capacity;
         }
+        data = stack->data;
+        length = start + args.length;
+        capacity = stack->capacity;
+        OWL_EVAL_NEXT();
+    }
 
-        eval->pc++;
+#ifndef OWL_EVAL_THREADED
+        }
     }
+#endif
 
-    return (eval->stack.length > 0 ? eval->stack.data[eval->stack.length - 1] : eval->gc->nothing);
+done:
+    stack->length = length;
+    eval->pc = (size_t)(end - code.code);
+    owl_gc_remove_scanner(gc, owl_eval_scan, eval);
+
+    return (length > 0 ? data[length - 1] : OWL_VALUE_NOTHING);
 }
 
+#ifdef OWL_EVAL_THREADED
+#pragma GCC diagnostic pop
+#endif
+
+#undef OWL_EVAL_RESERVE
+#undef OWL_EVAL_NEXT
+#undef OWL_EVAL_DISPATCH
+#undef OWL_EVAL_CASE
+
 Owl_Object *owl_eval(Owl_GC *gc, const Owl_Object *script) {
     Owl_Evaluator eval = owl_eval_init(gc);
 
-    Owl_Code code = owl_compile(&eval, script);
+    // The bytecode only lives for this call
+    Owl_Arena arena = owl_arena_init(gc->alloc);
+    Owl_Alloc scratch = owl_arena_alloc(&arena);
+
+    Owl_Code code = owl_compile_with(&eval, script, scratch);
+    owl_code_optimize(&code);
+
+    // Listings go straight to stdout a buffer at a time, anything stdio
+    // still holds has to go out first
+    char buffer[OWL_WRITER_BUFFER];
+    fflush(stdout);
+    Owl_Writer out = owl_writer_init(owl_fd_sink(STDOUT_FILENO), buffer, sizeof(buffer), scratch);
 
-    Owl_String str = owl_code_tostr(&code);
+    owl_writer_write_cstr(&out, "[ Bytecode ]\n");
+    owl_code_write(&out, &code);
+    owl_writer_write_cstr(&out, "\n");
+    owl_writer_flush(&out);
 
-    printf("[ Bytecode ]\n");
-    printf("%.*s\n", (int)str.length, str.data);
-    owl_string_del(&str, code.alloc);
-    
-    Owl_Object *final_result = owl_eval_code(&eval, code);
+    Owl_Value final_result = owl_eval_code(&eval, code);
 
-    Owl_String result_string = owl_object_tostring(final_result, gc->alloc);
-    
-    printf("[ Result ]\n");
-    printf("%.*s\n", (int)result_string.length, result_string.data);
+    owl_writer_write_cstr(&out, "[ Result ]\n");
+    owl_value_write(&out, final_result);
+    owl_writer_write_cstr(&out, "\n");
+    owl_writer_flush(&out);
 
-    owl_string_del(&result_string, code.alloc);
     owl_code_deinit(&code);
+    owl_arena_deinit(&arena);
     owl_eval_deinit(&eval);
 
     return NULL;
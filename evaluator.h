@@ -10,23 +10,22 @@
 #define OWL_INTRINSIC_LENGTH \
     16
 
-struct Owl_NamedIntrinsic {
-    const char *sym;
-    owl_intrinsic fn;
-};
-
-typedef struct Owl_NamedIntrinsic Owl_NamedIntrinsic;
-
 struct Owl_Evaluator {
     Owl_GC *gc;
 
     size_t pc;
     Owl_Stack stack;
 
+    Owl_Object *do_symbol;
+
     struct {
         Owl_NamedIntrinsic *fns;
         size_t length;
         size_t capacity;
+        // Symbol ids are dense, so indexing by id is a collision free hash,
+        // each entry holds the position in fns plus one or zero if unset
+        uint32_t *by_id;
+        size_t by_id_length;
     } intrinsics;
 };
 
@@ -35,13 +34,28 @@ typedef struct Owl_Evaluator Owl_Evaluator;
 Owl_Evaluator owl_eval_init(Owl_GC *gc);
 void owl_eval_deinit(Owl_Evaluator *eval);
 void owl_add_intrinsic(Owl_Evaluator *eval, owl_intrinsic intrinsic, const char *sym);
+// Registers count intrinsics after growing the registry once, only the
+// fn, sym and pure fields of each entry are read
+void owl_add_intrinsics(Owl_Evaluator *eval, const Owl_NamedIntrinsic *intrinsics, size_t count);
 void owl_compile_object(Owl_Evaluator *val, Owl_Code *code, Owl_Object *object);
 
-owl_intrinsic owl_get_intrinsic(Owl_Evaluator *eval, const char *sym);
+owl_intrinsic owl_get_intrinsic(Owl_Evaluator *eval, const Owl_Object *symbol);
+// The registry entry, NULL when the symbol names no intrinsic
+const Owl_NamedIntrinsic *owl_find_intrinsic(Owl_Evaluator *eval, const Owl_Object *symbol);
 
+// Calls to pure intrinsics whose arguments are all number literals are
+// evaluated here and compile to a push of the result. Objects they make
+// are rooted with the code like any other constant.
 Owl_Code owl_compile(Owl_Evaluator *eval, const Owl_Object *script);
 
-Owl_Object *owl_eval_code(Owl_Evaluator *eval, const Owl_Code code);
+// Compiles into memory taken from alloc, pass an arena allocator to release
+// the code and everything derived from it with a single reset. Pushed
+// objects other than symbols are rooted until owl_code_deinit.
+Owl_Code owl_compile_with(Owl_Evaluator *eval, const Owl_Object *script, Owl_Alloc alloc);
+
+// The value stack is a root while this runs, and the GC may collect at the
+// safepoint ahead of each intrinsic call
+Owl_Value owl_eval_code(Owl_Evaluator *eval, const Owl_Code code);
 
 Owl_Object *owl_eval(Owl_GC *gc, const Owl_Object *script);
 
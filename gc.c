@@ -4,15 +4,72 @@
 
 #include "gc.h"
 
+#include <pthread.h>
+#include <sched.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+
+struct Owl_GC_MarkWorker {
+    struct Owl_GC_MarkPool *pool;
+    pthread_t thread;
+
+    // Only touched by the owning thread
+    Owl_GC_Worklist local;
+
+    // Work offered to idle threads, taken in batches under the lock
+    pthread_mutex_t lock;
+    Owl_GC_Worklist shared;
+};
+
+typedef struct Owl_GC_MarkWorker Owl_GC_MarkWorker;
+
+// Worker 0 is the thread calling owl_gc_mark, the others wait for the
+// generation to change between collections
+struct Owl_GC_MarkPool {
+    Owl_GC *gc;
+    size_t count;
+
+    pthread_mutex_t lock;
+    pthread_cond_t start;
+    pthread_cond_t done;
+    size_t generation;
+    size_t finished;
+    Owl_Boolean stop;
+
+    // Workers that found nothing to do, marking ends when all of them are
+    size_t idle;
+
+    // The allocator isn't thread safe, worklists grow under this lock
+    pthread_mutex_t alloc_lock;
+
+    Owl_GC_MarkWorker workers[];
+};
+
+struct Owl_GC_Sweeper {
+    Owl_GC *gc;
+    pthread_t thread;
+
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t idle;
+    size_t generation;
+    Owl_Boolean busy;
+    Owl_Boolean stop;
+
+    // The old blocks as of owl_gc_sweep, the mutator may add more meanwhile
+    Owl_GC_Block **blocks;
+    size_t length;
+    size_t capacity;
+};
 
 void owl_list_append(Owl_GC *gc, Owl_Object *list, Owl_Object *value) {
     if (list == NULL || value == NULL) return;
     if (list->value == NULL) {
         list->value = value;
         list->next = NULL;
+        owl_gc_write_barrier(gc, list, value);
         return;
     }
     Owl_Object *it = list;
@@ -23,15 +80,88 @@ void owl_list_append(Owl_GC *gc, Owl_Object *list, Owl_Object *value) {
     node->value = value;
     node->next = NULL;
     it->next = node;
+    owl_gc_write_barrier(gc, it, node);
+}
+
+Owl_ListBuilder owl_list_builder(Owl_GC *gc) {
+    Owl_Object *list = owl_new_list(gc);
+    return (Owl_ListBuilder){.head = list, .tail = list, .length = 0};
+}
+
+Owl_ListBuilder owl_list_builder_from(Owl_Object *list) {
+    Owl_ListBuilder builder = {.head = list, .tail = list, .length = (list->value != NULL ? 1 : 0)};
+    while (builder.tail->next != NULL) {
+        builder.tail = builder.tail->next;
+        builder.length++;
+    }
+    return builder;
+}
+
+void owl_list_builder_append(Owl_GC *gc, Owl_ListBuilder *builder, Owl_Object *value) {
+    if (value == NULL) return;
+    // An empty list is a single node without a value
+    if (builder->length == 0) {
+        builder->head->value = value;
+        owl_gc_write_barrier(gc, builder->head, value);
+        builder->length = 1;
+        return;
+    }
+    Owl_Object *node = owl_gc_new(gc, OWL_LIST);
+    node->value = value;
+    node->next = NULL;
+    builder->tail->next = node;
+    owl_gc_write_barrier(gc, builder->tail, node);
+    builder->tail = node;
+    builder->length++;
+}
+
+static Owl_GC_MarkPool *owl_gc_pool_new(Owl_Alloc alloc, size_t count);
+static Owl_GC_Sweeper *owl_gc_sweeper_new(Owl_Alloc alloc);
+
+Owl_GC_Options owl_gc_default_options(void) {
+    return (Owl_GC_Options){
+        .mark_threads = 1,
+        .background_sweep = F,
+        .growth_factor = OWL_GC_GROWTH_FACTOR,
+        .compact = F,
+    };
 }
 
 Owl_GC owl_gc_init(const Owl_Alloc alloc) {
+    return owl_gc_init_with(alloc, owl_gc_default_options());
+}
+
+Owl_GC owl_gc_init_with(const Owl_Alloc alloc, const Owl_GC_Options options) {
     Owl_GC gc = (Owl_GC){
         .alloc = alloc,
-        .heap = NULL,
+        .blocks = {.data = NULL, .length = 0, .capacity = 0},
+        .spaces = {{0}},
+        .phase = OWL_GC_IDLE,
+        .unswept = 0,
+        .next_hash = 0,
+        .step_budget_us = OWL_GC_STEP_BUDGET_US,
         .roots = OWL_NEW(alloc, sizeof(Owl_GC_Header*)*OWL_ROOT_COUNT),
         .root_length = 0,
         .root_capacity = OWL_ROOT_COUNT,
+        .symbols = {.slots = NULL, .length = 0, .capacity = 0},
+        .mark_stack = {.data = NULL, .length = 0, .capacity = 0},
+        .remembered = {.data = NULL, .length = 0, .capacity = 0},
+        .young_pinned = {.data = NULL, .length = 0, .capacity = 0},
+        .young_finalizable = {.data = NULL, .length = 0, .capacity = 0},
+        .promoted = {.data = NULL, .length = 0, .capacity = 0},
+        .young_bytes = 0,
+        .scanners = {.data = NULL, .length = 0, .capacity = 0},
+        .visit = OWL_GC_VISIT_NONE,
+        .growth_factor = (options.growth_factor > 1.0 ? options.growth_factor : OWL_GC_GROWTH_FACTOR),
+        .allocated = 0,
+        .live_bytes = 0,
+        .threshold = OWL_GC_MIN_THRESHOLD,
+        .stats = {{0}},
+        .cycle = {0},
+        .on_cycle = {.callback = NULL, .context = NULL},
+        .mark_pool = (options.mark_threads > 1 ? owl_gc_pool_new(alloc, options.mark_threads) : NULL),
+        .sweeper = (options.background_sweep == T ? owl_gc_sweeper_new(alloc) : NULL),
+        .compact = options.compact,
         .nothing = NULL
     };
 
@@ -53,113 +183,1533 @@ void owl_gc_add_root(Owl_GC *gc, Owl_Object *root) {
             fprintf(stderr, "Failed to allocate roots\n");
             exit(1);
         }
+        memcpy(new_list, gc->roots, sizeof(Owl_GC_Header*)*gc->root_length);
+        OWL_DEL(gc->alloc, gc->roots);
+        gc->roots = new_list;
     }
     gc->roots[gc->root_length++] = OWL_GC_GET_HEADER(root);
 }
 
-Owl_Object *owl_gc_new(Owl_GC *self, const Owl_ObjectType type) {
-    Owl_GC_Header *header = OWL_NEW(self->alloc, sizeof(Owl_GC_Header) + sizeof(Owl_Object));
-    if (!header) {
-        fprintf(stderr, "Out of memory\n");
+void owl_gc_remove_root(Owl_GC *gc, Owl_Object *root) {
+    for (size_t i = gc->root_length; i-- > 0;) {
+        if (gc->roots[i] == OWL_GC_GET_HEADER(root)) {
+            gc->roots[i] = gc->roots[--gc->root_length];
+            return;
+        }
+    }
+}
+
+void owl_gc_add_scanner(Owl_GC *self, const owl_gc_scanner scanner, void *context) {
+    if (self->scanners.length >= self->scanners.capacity) {
+        const size_t capacity = (self->scanners.capacity == 0 ? OWL_ROOT_COUNT : self->scanners.capacity * 2);
+        Owl_GC_Scanner *data = OWL_NEW(self->alloc, sizeof(Owl_GC_Scanner) * capacity);
+        if (data == NULL) {
+            fprintf(stderr, "Failed to allocate roots\n");
+            exit(1);
+        }
+        if (self->scanners.data != NULL) {
+            memcpy(data, self->scanners.data, sizeof(Owl_GC_Scanner) * self->scanners.length);
+            OWL_DEL(self->alloc, self->scanners.data);
+        }
+        self->scanners.data = data;
+        self->scanners.capacity = capacity;
+    }
+    self->scanners.data[self->scanners.length++] = (Owl_GC_Scanner){.scan = scanner, .context = context};
+}
+
+void owl_gc_remove_scanner(Owl_GC *self, const owl_gc_scanner scanner, void *context) {
+    for (size_t i = self->scanners.length; i-- > 0;) {
+        if (self->scanners.data[i].scan == scanner && self->scanners.data[i].context == context) {
+            memmove(self->scanners.data + i, self->scanners.data + i + 1, sizeof(Owl_GC_Scanner) * (self->scanners.length - i - 1));
+            self->scanners.length--;
+            return;
+        }
+    }
+}
+
+static const size_t owl_object_payload_sizes[] = {
+    [OWL_NOTHING] = 0,
+    [OWL_NUMBER] = sizeof(double),
+    [OWL_BOOLEAN] = sizeof(Owl_Boolean),
+    [OWL_SYMBOL] = sizeof(Owl_Symbol),
+    [OWL_STRING] = sizeof(Owl_String),
+    [OWL_LIST] = sizeof(Owl_Object *) * 2,
+    [OWL_ARRAY] = sizeof(Owl_Object **) + sizeof(size_t) * 2,
+    [OWL_DICT] = sizeof(Owl_DictSlot *) + sizeof(size_t) * 2,
+    [OWL_F64_ARRAY] = sizeof(double *) + sizeof(size_t),
+    // Same slot as a string, flattening rewrites the object in place
+    [OWL_ROPE] = sizeof(Owl_String),
+};
+
+size_t owl_gc_object_size(const Owl_ObjectType type) {
+    // Free slots link through their first payload word
+    size_t payload = owl_object_payload_sizes[type];
+    payload = (payload < sizeof(void *) ? sizeof(void *) : (payload + 7) & ~(size_t)7);
+    return sizeof(Owl_GC_Header) + payload;
+}
+
+static Owl_GC_Space *owl_gc_space(Owl_GC *self, const size_t slot_size) {
+    return &self->spaces[slot_size / 8 - 2];
+}
+
+static Owl_GC_Header *owl_gc_slot(const Owl_GC_Block *block, const size_t slot) {
+    return (Owl_GC_Header *)(block->slots + slot * block->slot_size);
+}
+
+static uint64_t owl_gc_location(const Owl_GC_Block *block, const size_t slot) {
+    return ((uint64_t)block->index << OWL_GC_BLOCK_SHIFT) | ((uint64_t)slot << OWL_GC_SLOT_SHIFT);
+}
+
+static Owl_GC_Block *owl_gc_block_of(const Owl_GC *self, const Owl_Object *object) {
+    return self->blocks.data[OWL_GC_BLOCK_OF(OWL_GC_GET_HEADER(object)->word)];
+}
+
+static Owl_Boolean owl_gc_has_fields(const Owl_Object *object) {
+    switch (OWL_TYPE(object)) {
+        case OWL_LIST:
+        case OWL_ARRAY:
+        case OWL_DICT:
+        case OWL_ROPE:
+            return T;
+        default:
+            return F;
+    }
+}
+
+static void owl_gc_worklist_reserve(const Owl_Alloc alloc, Owl_GC_Worklist *list, const size_t length) {
+    if (length <= list->capacity) return;
+    size_t capacity = (list->capacity == 0 ? OWL_MARK_STACK_CAPACITY : list->capacity * 2);
+    while (capacity < length) {
+        capacity *= 2;
+    }
+    Owl_Object **data = OWL_NEW(alloc, sizeof(Owl_Object *) * capacity);
+    if (data == NULL) {
+        fprintf(stderr, "Failed to allocate GC worklist\n");
         exit(1);
     }
+    if (list->data != NULL) {
+        memcpy(data, list->data, sizeof(Owl_Object *) * list->length);
+        OWL_DEL(alloc, list->data);
+    }
+    list->data = data;
+    list->capacity = capacity;
+}
 
-    header->marked = F;
-    header->next = self->heap;
-    self->heap = header;
+static void owl_gc_worklist_push(Owl_GC *self, Owl_GC_Worklist *list, Owl_Object *object) {
+    owl_gc_worklist_reserve(self->alloc, list, list->length + 1);
+    list->data[list->length++] = object;
+}
 
-    Owl_Object *object = (Owl_Object *) (header + 1);
-    object->type = type;
-    return object;
+static uint64_t owl_gc_now_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
 }
 
-void owl_gc_mark_object(const Owl_Object *object) {
-    if (object == NULL) return;
+static uint64_t owl_gc_now_us(void) {
+    return owl_gc_now_ns() / 1000u;
+}
+
+static void owl_gc_histogram_add(Owl_GC_Histogram *histogram, const uint64_t ns) {
+    const uint64_t us = ns / 1000u;
+    size_t bucket = (us == 0 ? 0 : (size_t)(64 - __builtin_clzll(us)));
+    if (bucket >= OWL_GC_HISTOGRAM_BUCKETS) {
+        bucket = OWL_GC_HISTOGRAM_BUCKETS - 1;
+    }
+    histogram->buckets[bucket]++;
+    histogram->count++;
+    histogram->total_ns += ns;
+    if (ns > histogram->max_ns) {
+        histogram->max_ns = ns;
+    }
+}
+
+static void owl_gc_count_new(Owl_GC *self, const Owl_ObjectType type) {
+    self->stats.objects_allocated[type]++;
+    self->stats.bytes_allocated[type] += owl_gc_object_size(type);
+}
 
-    Owl_GC_Header *h = OWL_GC_GET_HEADER(object);
-    if (h->marked == T) return;
-    h->marked = T;
+// Objects created while marking is underway or complete count as reachable
+static Owl_Boolean owl_gc_allocates_black(const Owl_GC *self) {
+    return (self->phase == OWL_GC_MARKING || self->phase == OWL_GC_MARKED ? T : F);
+}
+
+static void owl_gc_worklist_free(const Owl_Alloc alloc, Owl_GC_Worklist *list) {
+    if (list->data != NULL) {
+        OWL_DEL(alloc, list->data);
+    }
+    *list = (Owl_GC_Worklist){.data = NULL, .length = 0, .capacity = 0};
+}
 
-    switch (object->type) {
-        case OWL_NOTHING:
-        case OWL_NUMBER:
-        case OWL_BOOLEAN:
-        case OWL_SYMBOL:
+static void owl_gc_finalize(Owl_GC *self, Owl_Object *object) {
+    switch (OWL_TYPE(object)) {
         case OWL_STRING:
-            OWL_GC_GET_HEADER(object)->marked = T;
+            owl_string_del(&object->string, self->alloc);
+            break;
+        case OWL_ARRAY:
+            OWL_DEL(self->alloc, object->array);
+            break;
+        case OWL_F64_ARRAY:
+            OWL_DEL(self->alloc, object->f64);
             break;
-        case OWL_LIST: {
-            const Owl_Object *list = (Owl_Object *) object;
-            owl_gc_mark_object(list->value);
-            owl_gc_mark_object(list->next);
+        case OWL_DICT:
+            if (object->dict_slots != NULL) {
+                OWL_DEL(self->alloc, object->dict_slots);
+            }
             break;
+        default:
+            break;
+    }
+}
+
+static void owl_gc_link_block(Owl_GC_Block **first, Owl_GC_Block **last, Owl_GC_Block *block) {
+    block->next = NULL;
+    if (*last != NULL) {
+        (*last)->next = block;
+    } else {
+        *first = block;
+    }
+    *last = block;
+}
+
+static Owl_GC_Block *owl_gc_add_block(Owl_GC *self, const size_t slot_size, const Owl_Boolean young) {
+    if (self->blocks.length > OWL_GC_BLOCK_MASK) {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+    if (self->blocks.length >= self->blocks.capacity) {
+        const size_t capacity = (self->blocks.capacity == 0 ? 16 : self->blocks.capacity * 2);
+        Owl_GC_Block **data = OWL_NEW(self->alloc, sizeof(Owl_GC_Block *) * capacity);
+        if (data == NULL) {
+            fprintf(stderr, "Out of memory\n");
+            exit(1);
+        }
+        if (self->blocks.data != NULL) {
+            memcpy(data, self->blocks.data, sizeof(Owl_GC_Block *) * self->blocks.length);
+            OWL_DEL(self->alloc, self->blocks.data);
+        }
+        self->blocks.data = data;
+        self->blocks.capacity = capacity;
+    }
+
+    Owl_GC_Block *block = OWL_NEW(self->alloc, sizeof(Owl_GC_Block) + OWL_GC_BLOCK_SIZE);
+    if (block == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+    *block = (Owl_GC_Block){
+        .next = NULL,
+        .index = self->blocks.length,
+        .slot_size = slot_size,
+        .slot_count = OWL_GC_BLOCK_SIZE / slot_size,
+        .live = 0,
+        .swept = T,
+        .claimed = F,
+        .young = young,
+        .bump = 0,
+        .retained = 0,
+        .free_list = NULL,
+        .marks = {0},
+        .slots = (char *)(block + 1),
+    };
+
+    self->blocks.data[self->blocks.length++] = block;
+
+    Owl_GC_Space *space = owl_gc_space(self, slot_size);
+    if (young == T) {
+        // Header words are written as the bump pointer reaches each slot
+        owl_gc_link_block(&space->young_first, &space->young_last, block);
+        return block;
+    }
+    for (size_t i = block->slot_count; i-- > 0;) {
+        Owl_GC_Header *slot = owl_gc_slot(block, i);
+        slot->word = owl_gc_location(block, i);
+        *(Owl_GC_Header **)(slot + 1) = block->free_list;
+        block->free_list = slot;
+    }
+    owl_gc_link_block(&space->first, &space->last, block);
+    return block;
+}
+
+// May run on the sweeper thread, the mutator can be setting bits in the
+// header words of live objects at the same time
+static void owl_gc_sweep_block(Owl_GC *self, Owl_GC_Block *block) {
+    const uint64_t started = owl_gc_now_ns();
+    size_t freed = 0;
+    block->free_list = NULL;
+    block->live = 0;
+    for (size_t i = block->slot_count; i-- > 0;) {
+        Owl_GC_Header *slot = owl_gc_slot(block, i);
+        const uint64_t word = __atomic_load_n(&slot->word, __ATOMIC_RELAXED);
+        if ((word & OWL_GC_LIVE_BIT) != 0) {
+            const Owl_Boolean marked = ((block->marks[i / 64] >> (i % 64)) & 1) != 0 ? T : F;
+            if (marked == T || (word & OWL_GC_PINNED_BIT) != 0) {
+                block->live++;
+                continue;
+            }
+            owl_gc_finalize(self, OWL_GC_OBJECT_FROM_HEADER(slot));
+            slot->word = word & OWL_GC_LOCATION_MASK;
+            freed++;
+        }
+        *(Owl_GC_Header **)(slot + 1) = block->free_list;
+        block->free_list = slot;
+    }
+    __atomic_add_fetch(&self->cycle.freed_objects, freed, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&self->cycle.freed_bytes, freed * block->slot_size, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&self->cycle.sweep_ns, owl_gc_now_ns() - started, __ATOMIC_RELAXED);
+    // Counted down first, whoever sees the block swept also sees it gone
+    // from unswept and can end the cycle after the last one
+    __atomic_sub_fetch(&self->unswept, 1, __ATOMIC_ACQ_REL);
+    __atomic_store_n(&block->swept, T, __ATOMIC_RELEASE);
+}
+
+// Sweeps the block unless another thread claimed it first, in which case
+// this waits for that thread to finish with it
+static void owl_gc_ensure_swept(Owl_GC *self, Owl_GC_Block *block) {
+    if (__atomic_load_n(&block->swept, __ATOMIC_ACQUIRE) == T) return;
+    if (__atomic_exchange_n(&block->claimed, T, __ATOMIC_ACQ_REL) == F) {
+        owl_gc_sweep_block(self, block);
+        return;
+    }
+    while (__atomic_load_n(&block->swept, __ATOMIC_ACQUIRE) == F) {
+        sched_yield();
+    }
+}
+
+// Reports the cycle once it has been swept, or once the next one starts
+// when it never was
+static void owl_gc_end_cycle(Owl_GC *self) {
+    Owl_GC_Cycle *cycle = &self->cycle;
+    cycle->number = ++self->stats.collections;
+    self->stats.freed_objects += cycle->freed_objects;
+    self->stats.freed_bytes += cycle->freed_bytes;
+    owl_gc_histogram_add(&self->stats.mark, cycle->mark_ns);
+    owl_gc_histogram_add(&self->stats.sweep, cycle->sweep_ns);
+    self->stats.last = *cycle;
+    if (self->on_cycle.callback != NULL) {
+        self->on_cycle.callback(self, &self->stats.last, self->on_cycle.context);
+    }
+}
+
+// Only the mutator changes the phase, the sweeper just counts down
+static void owl_gc_sweep_progress(Owl_GC *self) {
+    if (self->phase == OWL_GC_SWEEPING && __atomic_load_n(&self->unswept, __ATOMIC_ACQUIRE) == 0) {
+        self->phase = OWL_GC_IDLE;
+        owl_gc_end_cycle(self);
+    }
+}
+
+static void owl_gc_set_mark(const Owl_GC *self, const uint64_t word) {
+    Owl_GC_Block *block = self->blocks.data[OWL_GC_BLOCK_OF(word)];
+    const size_t slot = OWL_GC_SLOT_OF(word);
+    block->marks[slot / 64] |= (uint64_t)1 << (slot % 64);
+}
+
+Owl_Boolean owl_gc_is_marked(const Owl_GC *self, const Owl_Object *object) {
+    const uint64_t word = OWL_GC_GET_HEADER(object)->word;
+    const Owl_GC_Block *block = self->blocks.data[OWL_GC_BLOCK_OF(word)];
+    const size_t slot = OWL_GC_SLOT_OF(word);
+    return ((block->marks[slot / 64] >> (slot % 64)) & 1) != 0 ? T : F;
+}
+
+// Consecutive objects get hashes far apart
+static uint64_t owl_gc_identity(Owl_GC *self) {
+    self->next_hash += 0x9e3779b97f4a7c15u;
+    return self->next_hash & OWL_GC_HASH_BITS;
+}
+
+static Owl_Object *owl_gc_new_old(Owl_GC *self, const Owl_ObjectType type) {
+    const size_t slot_size = owl_gc_object_size(type);
+    Owl_GC_Space *space = owl_gc_space(self, slot_size);
+
+    Owl_GC_Block *block = space->cursor;
+    for (;;) {
+        if (block == NULL) {
+            block = owl_gc_add_block(self, slot_size, F);
+        }
+        if (__atomic_load_n(&block->swept, __ATOMIC_ACQUIRE) == F) {
+            owl_gc_ensure_swept(self, block);
+            owl_gc_sweep_progress(self);
         }
-        case OWL_DICT: {
-            const Owl_Object *list = (Owl_Object *) object;
-            owl_gc_mark_object(list->dict_key);
-            owl_gc_mark_object(list->dict_value);
-            owl_gc_mark_object(list->dict_next);
+        if (block->free_list != NULL) {
             break;
         }
+        block = block->next;
+    }
+    space->cursor = block;
+
+    Owl_GC_Header *header = block->free_list;
+    block->free_list = *(Owl_GC_Header **)(header + 1);
+    block->live++;
+
+    header->word = (header->word & OWL_GC_LOCATION_MASK) | owl_gc_identity(self) | OWL_GC_LIVE_BIT | (uint64_t)type;
+    self->allocated += slot_size;
+    if (owl_gc_allocates_black(self) == T) {
+        owl_gc_set_mark(self, header->word);
+    }
+
+    return OWL_GC_OBJECT_FROM_HEADER(header);
+}
+
+Owl_Object *owl_gc_new(Owl_GC *self, const Owl_ObjectType type) {
+    const size_t slot_size = owl_gc_object_size(type);
+    Owl_GC_Space *space = owl_gc_space(self, slot_size);
+
+    Owl_GC_Block *block = space->nursery;
+    while (block != NULL && block->bump >= block->slot_count) {
+        block = block->next;
+    }
+    if (block == NULL) {
+        block = owl_gc_add_block(self, slot_size, T);
+    }
+    space->nursery = block;
+
+    const size_t slot = block->bump++;
+    Owl_GC_Header *header = owl_gc_slot(block, slot);
+    header->word = owl_gc_location(block, slot) | owl_gc_identity(self) | OWL_GC_LIVE_BIT | (uint64_t)type;
+    self->young_bytes += slot_size;
+    owl_gc_count_new(self, type);
+
+    Owl_Object *object = OWL_GC_OBJECT_FROM_HEADER(header);
+    // Ropes may own a buffer by the time they die, once flattened
+    if (type == OWL_STRING || type == OWL_ROPE || type == OWL_ARRAY || type == OWL_DICT || type == OWL_F64_ARRAY) {
+        owl_gc_worklist_push(self, &self->young_finalizable, object);
+    }
+    return object;
+}
+
+Owl_Boolean owl_gc_is_young(const Owl_GC *self, const Owl_Object *object) {
+    return owl_gc_block_of(self, object)->young;
+}
+
+static void owl_gc_mark_defer(Owl_GC *self, Owl_GC_MarkWorker *worker, Owl_Object *object);
+
+void owl_gc_write_barrier(Owl_GC *self, Owl_Object *parent, Owl_Object *child) {
+    if (child == NULL || owl_gc_block_of(self, parent)->young == T) return;
+
+    Owl_GC_Header *header = OWL_GC_GET_HEADER(parent);
+    if (owl_gc_block_of(self, child)->young == T) {
+        // Young survivors come out of the nursery already marked
+        if ((header->word & OWL_GC_REMEMBERED_BIT) == 0) {
+            __atomic_fetch_or(&header->word, OWL_GC_REMEMBERED_BIT, __ATOMIC_RELAXED);
+            owl_gc_worklist_push(self, &self->remembered, parent);
+        }
+        return;
+    }
+    // Insertion barrier, a marked object must never point at a white one
+    if (self->phase == OWL_GC_MARKING && owl_gc_is_marked(self, parent) == T) {
+        owl_gc_mark_defer(self, NULL, child);
+    }
+}
+
+// Keeps a young object where it is, its block is promoted as a whole
+static void owl_gc_retain(Owl_GC *self, Owl_Object *object) {
+    Owl_GC_Header *header = OWL_GC_GET_HEADER(object);
+    if ((header->word & OWL_GC_RETAINED_BIT) != 0) return;
+    header->word |= OWL_GC_RETAINED_BIT;
+    owl_gc_block_of(self, object)->retained++;
+    if (owl_gc_has_fields(object) == T) {
+        owl_gc_worklist_push(self, &self->promoted, object);
+    }
+}
+
+// Returns where a young object lives after the minor collection
+static Owl_Object *owl_gc_evacuate(Owl_GC *self, Owl_Object *object) {
+    if (object == NULL || owl_gc_block_of(self, object)->young == F) return object;
+
+    Owl_GC_Header *header = OWL_GC_GET_HEADER(object);
+    if ((header->word & OWL_GC_FORWARDED_BIT) != 0) {
+        return *(Owl_Object **)object;
+    }
+    if ((header->word & (OWL_GC_PINNED_BIT | OWL_GC_RETAINED_BIT)) != 0) {
+        owl_gc_retain(self, object);
+        return object;
+    }
+
+    const Owl_ObjectType type = OWL_TYPE(object);
+    Owl_Object *copy = owl_gc_new_old(self, type);
+    memcpy(copy, object, owl_gc_object_size(type) - sizeof(Owl_GC_Header));
+    Owl_GC_Header *moved = OWL_GC_GET_HEADER(copy);
+    moved->word = (moved->word & ~OWL_GC_HASH_BITS) | (header->word & OWL_GC_HASH_BITS);
+    self->stats.promoted_bytes += owl_gc_object_size(type);
+    header->word |= OWL_GC_FORWARDED_BIT;
+    *(Owl_Object **)object = copy;
+    if (owl_gc_has_fields(copy) == T) {
+        owl_gc_worklist_push(self, &self->promoted, copy);
+        // The copy is born marked but its old fields may still be white
+        if (self->phase == OWL_GC_MARKING) {
+            owl_gc_worklist_push(self, &self->mark_stack, copy);
+        }
+    }
+    return copy;
+}
+
+static void owl_gc_evacuate_fields(Owl_GC *self, Owl_Object *object) {
+    switch (OWL_TYPE(object)) {
+        case OWL_LIST:
+            object->value = owl_gc_evacuate(self, object->value);
+            object->next = owl_gc_evacuate(self, object->next);
+            break;
+        case OWL_ROPE:
+            object->rope_left = owl_gc_evacuate(self, object->rope_left);
+            object->rope_right = owl_gc_evacuate(self, object->rope_right);
+            break;
+        case OWL_DICT:
+            for (size_t i = 0; i < object->dict_capacity; i++) {
+                Owl_DictSlot *slot = &object->dict_slots[i];
+                if (slot->distance == 0) continue;
+                slot->key = owl_gc_evacuate(self, slot->key);
+                slot->value = owl_gc_evacuate(self, slot->value);
+            }
+            break;
         case OWL_ARRAY:
-            // TODO: what should I do here?
+            for (size_t i = 0; i < object->length; i++) {
+                object->array[i] = owl_gc_evacuate(self, object->array[i]);
+            }
+            break;
+        default:
             break;
+    }
+}
+
+// Turns a nursery block holding retained objects into an old block, the
+// rest of its slots go on the free list
+static void owl_gc_promote_block(Owl_GC *self, Owl_GC_Space *space, Owl_GC_Block *block) {
+    block->young = F;
+    block->free_list = NULL;
+    block->live = 0;
+    memset(block->marks, 0, sizeof(block->marks));
+    for (size_t i = block->slot_count; i-- > 0;) {
+        Owl_GC_Header *slot = owl_gc_slot(block, i);
+        if (i < block->bump && (slot->word & OWL_GC_RETAINED_BIT) != 0) {
+            slot->word &= ~OWL_GC_RETAINED_BIT;
+            block->live++;
+            if (owl_gc_allocates_black(self) == T) {
+                block->marks[i / 64] |= (uint64_t)1 << (i % 64);
+            }
+            Owl_Object *object = OWL_GC_OBJECT_FROM_HEADER(slot);
+            if (self->phase == OWL_GC_MARKING && owl_gc_has_fields(object) == T) {
+                owl_gc_worklist_push(self, &self->mark_stack, object);
+            }
+            continue;
         }
+        slot->word = owl_gc_location(block, i);
+        *(Owl_GC_Header **)(slot + 1) = block->free_list;
+        block->free_list = slot;
+    }
+    block->bump = 0;
+    block->retained = 0;
+    self->allocated += block->live * block->slot_size;
+    self->stats.promoted_bytes += block->live * block->slot_size;
+    owl_gc_link_block(&space->first, &space->last, block);
+    if (space->cursor == NULL) {
+        space->cursor = block;
+    }
+}
+
+// While owl_gc_compact runs, the location bits of a live object's header
+// name the slot it is moving to rather than the one it is in
+static Owl_Object *owl_gc_forwarded(const Owl_GC *self, Owl_Object *object) {
+    if (object == NULL) return NULL;
+    const uint64_t word = OWL_GC_GET_HEADER(object)->word;
+    return OWL_GC_OBJECT_FROM_HEADER(owl_gc_slot(self->blocks.data[OWL_GC_BLOCK_OF(word)], OWL_GC_SLOT_OF(word)));
+}
+
+static void owl_gc_run_scanners(Owl_GC *self, const Owl_GC_Visit visit) {
+    self->visit = visit;
+    for (size_t i = 0; i < self->scanners.length; i++) {
+        self->scanners.data[i].scan(self, self->scanners.data[i].context);
+    }
+    self->visit = OWL_GC_VISIT_NONE;
+}
+
+void owl_gc_visit(Owl_GC *self, Owl_Value *slot) {
+    if (!OWL_VALUE_IS_OBJECT(*slot)) return;
+    Owl_Object *object = OWL_VALUE_AS_OBJECT(*slot);
+    switch (self->visit) {
+        case OWL_GC_VISIT_MINOR:
+            *slot = OWL_VALUE_OBJECT(owl_gc_evacuate(self, object));
+            break;
+        case OWL_GC_VISIT_MARK:
+            owl_gc_mark_defer(self, NULL, object);
+            break;
+        case OWL_GC_VISIT_COMPACT:
+            *slot = OWL_VALUE_OBJECT(owl_gc_forwarded(self, object));
+            break;
+        case OWL_GC_VISIT_NONE:
+            break;
+    }
 }
 
-void owl_gc_mark(const Owl_GC *self) {
+void owl_gc_minor(Owl_GC *self) {
+    if (self->young_bytes == 0) return;
+    self->stats.minor_collections++;
+    self->stats.young_bytes += self->young_bytes;
+
+    // Everything that must not move is claimed before anything is copied
     for (size_t i = 0; i < self->root_length; i++) {
-        Owl_GC_Header *root = self->roots[i];
-        if (root == NULL) continue;
-        const Owl_Object *object = OWL_GC_OBJECT_FROM_HEADER(root);
-        owl_gc_mark_object(object);
+        if (self->roots[i] == NULL) continue;
+        Owl_Object *root = OWL_GC_OBJECT_FROM_HEADER(self->roots[i]);
+        if (owl_gc_block_of(self, root)->young == T) {
+            owl_gc_retain(self, root);
+        }
+    }
+    for (size_t i = 0; i < self->young_pinned.length; i++) {
+        owl_gc_retain(self, self->young_pinned.data[i]);
+    }
+    owl_gc_run_scanners(self, OWL_GC_VISIT_MINOR);
+
+    for (size_t i = 0; i < self->remembered.length; i++) {
+        Owl_Object *parent = self->remembered.data[i];
+        Owl_GC_Header *header = OWL_GC_GET_HEADER(parent);
+        // The bit is gone if the lazy sweeper has reclaimed the slot
+        if ((header->word & OWL_GC_REMEMBERED_BIT) == 0) continue;
+        __atomic_fetch_and(&header->word, ~OWL_GC_REMEMBERED_BIT, __ATOMIC_RELAXED);
+        owl_gc_evacuate_fields(self, parent);
+    }
+    while (self->promoted.length > 0) {
+        owl_gc_evacuate_fields(self, self->promoted.data[--self->promoted.length]);
+    }
+
+    for (size_t i = 0; i < self->young_finalizable.length; i++) {
+        Owl_Object *object = self->young_finalizable.data[i];
+        if ((OWL_GC_GET_HEADER(object)->word & (OWL_GC_FORWARDED_BIT | OWL_GC_RETAINED_BIT)) == 0) {
+            owl_gc_finalize(self, object);
+        }
+    }
+
+    for (size_t i = 0; i < OWL_GC_SPACE_COUNT; i++) {
+        Owl_GC_Space *space = &self->spaces[i];
+        Owl_GC_Block *block = space->young_first;
+        space->young_first = NULL;
+        space->young_last = NULL;
+        while (block != NULL) {
+            Owl_GC_Block *next = block->next;
+            if (block->retained > 0) {
+                owl_gc_promote_block(self, space, block);
+            } else {
+                block->bump = 0;
+                owl_gc_link_block(&space->young_first, &space->young_last, block);
+            }
+            block = next;
+        }
+        space->nursery = space->young_first;
+    }
+
+    self->remembered.length = 0;
+    self->young_pinned.length = 0;
+    self->young_finalizable.length = 0;
+    self->young_bytes = 0;
+}
+
+// Sets the mark bit, returns the object if it still has to be scanned.
+// Parallel markers race on the bitmap words, so they set bits atomically.
+static Owl_Object *owl_gc_mark_take(const Owl_GC *self, Owl_Object *object, const Owl_Boolean atomic) {
+    if (object == NULL) return NULL;
+
+    const uint64_t word = OWL_GC_GET_HEADER(object)->word;
+    Owl_GC_Block *block = self->blocks.data[OWL_GC_BLOCK_OF(word)];
+    const size_t slot = OWL_GC_SLOT_OF(word);
+    const uint64_t bit = (uint64_t)1 << (slot % 64);
+    if (atomic == T) {
+        if ((__atomic_fetch_or(&block->marks[slot / 64], bit, __ATOMIC_RELAXED) & bit) != 0) return NULL;
+    } else {
+        if ((block->marks[slot / 64] & bit) != 0) return NULL;
+        block->marks[slot / 64] |= bit;
+    }
+
+    return (owl_gc_has_fields(object) == T ? object : NULL);
+}
+
+static void owl_gc_worker_push(Owl_GC_MarkWorker *worker, Owl_Object *object) {
+    if (worker->local.length >= worker->local.capacity) {
+        pthread_mutex_lock(&worker->pool->alloc_lock);
+        owl_gc_worklist_reserve(worker->pool->gc->alloc, &worker->local, worker->local.length + 1);
+        pthread_mutex_unlock(&worker->pool->alloc_lock);
+    }
+    worker->local.data[worker->local.length++] = object;
+}
+
+// Without a worker this is the serial marker working off the mark stack
+static void owl_gc_mark_defer(Owl_GC *self, Owl_GC_MarkWorker *worker, Owl_Object *object) {
+    object = owl_gc_mark_take(self, object, (worker != NULL ? T : F));
+    if (object == NULL) return;
+    if (worker != NULL) {
+        owl_gc_worker_push(worker, object);
+    } else {
+        owl_gc_worklist_push(self, &self->mark_stack, object);
+    }
+}
+
+// Descends into the value side directly and leaves the rest of the chain
+// on the mark stack, so a flat list never needs more than one entry
+static void owl_gc_scan(Owl_GC *self, Owl_GC_MarkWorker *worker, Owl_Object *object) {
+    const Owl_Boolean atomic = (worker != NULL ? T : F);
+    while (object != NULL) {
+        switch (OWL_TYPE(object)) {
+            case OWL_LIST:
+                owl_gc_mark_defer(self, worker, object->next);
+                object = owl_gc_mark_take(self, object->value, atomic);
+                break;
+            case OWL_ROPE:
+                // Repeated appends build ropes that lean left
+                owl_gc_mark_defer(self, worker, object->rope_right);
+                object = owl_gc_mark_take(self, object->rope_left, atomic);
+                break;
+            case OWL_DICT:
+                for (size_t i = 0; i < object->dict_capacity; i++) {
+                    if (object->dict_slots[i].distance == 0) continue;
+                    owl_gc_mark_defer(self, worker, object->dict_slots[i].key);
+                    owl_gc_mark_defer(self, worker, object->dict_slots[i].value);
+                }
+                object = NULL;
+                break;
+            case OWL_ARRAY:
+                for (size_t i = 0; i < object->length; i++) {
+                    owl_gc_mark_defer(self, worker, object->array[i]);
+                }
+                object = NULL;
+                break;
+            default:
+                object = NULL;
+                break;
+        }
+    }
+}
+
+void owl_gc_mark_object(Owl_GC *self, Owl_Object *object) {
+    owl_gc_scan(self, NULL, owl_gc_mark_take(self, object, F));
+    while (self->mark_stack.length > 0) {
+        owl_gc_scan(self, NULL, self->mark_stack.data[--self->mark_stack.length]);
+    }
+}
+
+// Hands the older half of a long private stack to the shared list once
+// the previous batch has been taken
+static void owl_gc_worker_share(Owl_GC_MarkWorker *worker) {
+    if (worker->local.length < OWL_GC_SHARE_THRESHOLD) return;
+    if (__atomic_load_n(&worker->shared.length, __ATOMIC_RELAXED) != 0) return;
+
+    const size_t count = worker->local.length / 2;
+    pthread_mutex_lock(&worker->lock);
+    if (worker->shared.length == 0) {
+        pthread_mutex_lock(&worker->pool->alloc_lock);
+        owl_gc_worklist_reserve(worker->pool->gc->alloc, &worker->shared, count);
+        pthread_mutex_unlock(&worker->pool->alloc_lock);
+        memcpy(worker->shared.data, worker->local.data, sizeof(Owl_Object *) * count);
+        __atomic_store_n(&worker->shared.length, count, __ATOMIC_RELAXED);
+
+        worker->local.length -= count;
+        memmove(worker->local.data, worker->local.data + count, sizeof(Owl_Object *) * worker->local.length);
     }
+    pthread_mutex_unlock(&worker->lock);
+}
+
+// Takes the whole shared list of the worker itself, or half of another's
+static Owl_Boolean owl_gc_worker_take(Owl_GC_MarkWorker *worker, Owl_GC_MarkWorker *victim) {
+    if (__atomic_load_n(&victim->shared.length, __ATOMIC_RELAXED) == 0) return F;
+
+    pthread_mutex_lock(&victim->lock);
+    const size_t length = victim->shared.length;
+    const size_t count = (victim == worker ? length : (length + 1) / 2);
+    for (size_t i = length - count; i < length; i++) {
+        owl_gc_worker_push(worker, victim->shared.data[i]);
+    }
+    __atomic_store_n(&victim->shared.length, length - count, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&victim->lock);
+    return (count > 0 ? T : F);
+}
+
+static Owl_Boolean owl_gc_worker_steal(Owl_GC_MarkWorker *worker) {
+    Owl_GC_MarkPool *pool = worker->pool;
+    const size_t self_index = (size_t)(worker - pool->workers);
+    for (size_t i = 0; i < pool->count; i++) {
+        if (owl_gc_worker_take(worker, &pool->workers[(self_index + i) % pool->count]) == T) {
+            return T;
+        }
+    }
+    return F;
+}
+
+static Owl_Boolean owl_gc_pool_has_work(Owl_GC_MarkPool *pool) {
+    for (size_t i = 0; i < pool->count; i++) {
+        if (__atomic_load_n(&pool->workers[i].shared.length, __ATOMIC_RELAXED) != 0) {
+            return T;
+        }
+    }
+    return F;
+}
+
+// Workers only ever add to their own lists, so once every worker is idle
+// with nothing left to steal no more work can appear
+static void owl_gc_mark_work(Owl_GC_MarkWorker *worker) {
+    Owl_GC_MarkPool *pool = worker->pool;
+    for (;;) {
+        while (worker->local.length > 0) {
+            owl_gc_scan(pool->gc, worker, worker->local.data[--worker->local.length]);
+            owl_gc_worker_share(worker);
+        }
+        if (owl_gc_worker_steal(worker) == T) continue;
+
+        __atomic_add_fetch(&pool->idle, 1, __ATOMIC_SEQ_CST);
+        for (;;) {
+            if (__atomic_load_n(&pool->idle, __ATOMIC_SEQ_CST) == pool->count) return;
+            if (owl_gc_pool_has_work(pool) == T) {
+                __atomic_sub_fetch(&pool->idle, 1, __ATOMIC_SEQ_CST);
+                break;
+            }
+            sched_yield();
+        }
+    }
+}
+
+static void *owl_gc_mark_thread(void *arg) {
+    Owl_GC_MarkWorker *worker = arg;
+    Owl_GC_MarkPool *pool = worker->pool;
+    size_t generation = 0;
+    for (;;) {
+        pthread_mutex_lock(&pool->lock);
+        while (pool->generation == generation && pool->stop == F) {
+            pthread_cond_wait(&pool->start, &pool->lock);
+        }
+        if (pool->stop == T) {
+            pthread_mutex_unlock(&pool->lock);
+            return NULL;
+        }
+        generation = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+
+        owl_gc_mark_work(worker);
+
+        pthread_mutex_lock(&pool->lock);
+        pool->finished++;
+        pthread_cond_signal(&pool->done);
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
+
+static Owl_GC_MarkPool *owl_gc_pool_new(const Owl_Alloc alloc, const size_t count) {
+    Owl_GC_MarkPool *pool = OWL_NEW(alloc, sizeof(Owl_GC_MarkPool) + sizeof(Owl_GC_MarkWorker) * count);
+    if (pool == NULL) {
+        fprintf(stderr, "Failed to allocate mark threads\n");
+        exit(1);
+    }
+    pool->gc = NULL;
+    pool->count = count;
+    pool->generation = 0;
+    pool->finished = 0;
+    pool->stop = F;
+    pool->idle = 0;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->start, NULL);
+    pthread_cond_init(&pool->done, NULL);
+    pthread_mutex_init(&pool->alloc_lock, NULL);
+
+    for (size_t i = 0; i < count; i++) {
+        Owl_GC_MarkWorker *worker = &pool->workers[i];
+        worker->pool = pool;
+        worker->local = (Owl_GC_Worklist){.data = NULL, .length = 0, .capacity = 0};
+        worker->shared = (Owl_GC_Worklist){.data = NULL, .length = 0, .capacity = 0};
+        pthread_mutex_init(&worker->lock, NULL);
+        if (i > 0 && pthread_create(&worker->thread, NULL, owl_gc_mark_thread, worker) != 0) {
+            fprintf(stderr, "Failed to start mark thread\n");
+            exit(1);
+        }
+    }
+    return pool;
+}
+
+static void owl_gc_pool_free(const Owl_Alloc alloc, Owl_GC_MarkPool *pool) {
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = T;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (size_t i = 0; i < pool->count; i++) {
+        Owl_GC_MarkWorker *worker = &pool->workers[i];
+        if (i > 0) {
+            pthread_join(worker->thread, NULL);
+        }
+        pthread_mutex_destroy(&worker->lock);
+        owl_gc_worklist_free(alloc, &worker->local);
+        owl_gc_worklist_free(alloc, &worker->shared);
+    }
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->start);
+    pthread_cond_destroy(&pool->done);
+    pthread_mutex_destroy(&pool->alloc_lock);
+    OWL_DEL(alloc, pool);
+}
+
+static void owl_gc_mark_parallel(Owl_GC *self) {
+    Owl_GC_MarkPool *pool = self->mark_pool;
+    pool->gc = self;
+    pool->idle = 0;
+
+    // Roots are dealt out before the helpers wake up
+    size_t next = 0;
+    for (size_t i = 0; i < self->root_length; i++) {
+        if (self->roots[i] == NULL) continue;
+        Owl_GC_MarkWorker *worker = &pool->workers[next++ % pool->count];
+        owl_gc_mark_defer(self, worker, OWL_GC_OBJECT_FROM_HEADER(self->roots[i]));
+    }
+    owl_gc_run_scanners(self, OWL_GC_VISIT_MARK);
+    while (self->mark_stack.length > 0) {
+        owl_gc_worker_push(&pool->workers[next++ % pool->count], self->mark_stack.data[--self->mark_stack.length]);
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->generation++;
+    pool->finished = 0;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    owl_gc_mark_work(&pool->workers[0]);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->finished < pool->count - 1) {
+        pthread_cond_wait(&pool->done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+static void owl_gc_shade_roots(Owl_GC *self) {
+    for (size_t i = 0; i < self->root_length; i++) {
+        if (self->roots[i] == NULL) continue;
+        owl_gc_mark_defer(self, NULL, OWL_GC_OBJECT_FROM_HEADER(self->roots[i]));
+    }
+    owl_gc_run_scanners(self, OWL_GC_VISIT_MARK);
+}
+
+static void owl_gc_count_marked(Owl_GC *self) {
+    self->cycle.surviving_objects = 0;
+    self->cycle.surviving_bytes = 0;
+    for (size_t i = 0; i < self->blocks.length; i++) {
+        const Owl_GC_Block *block = self->blocks.data[i];
+        size_t marked = 0;
+        for (size_t j = 0; j < OWL_GC_MARK_WORDS; j++) {
+            marked += (size_t)__builtin_popcountll(block->marks[j]);
+        }
+        self->cycle.surviving_objects += marked;
+        self->cycle.surviving_bytes += marked * block->slot_size;
+    }
+}
+
+// The next collection is due once the old space has grown by the growth
+// factor over what survived this one
+static void owl_gc_end_mark(Owl_GC *self) {
+    self->phase = OWL_GC_MARKED;
+    owl_gc_count_marked(self);
+    self->live_bytes = self->cycle.surviving_bytes;
+    self->allocated = 0;
+    const double target = (double)self->live_bytes * self->growth_factor;
+    self->threshold = (target > (double)OWL_GC_MIN_THRESHOLD ? (size_t)target : OWL_GC_MIN_THRESHOLD);
+}
+
+static void owl_gc_begin_mark(Owl_GC *self) {
+    owl_gc_minor(self);
+    owl_gc_finish_sweep(self);
+    if (self->phase == OWL_GC_MARKED) {
+        owl_gc_end_cycle(self);
+    }
+    self->cycle = (Owl_GC_Cycle){0};
+    self->mark_stack.length = 0;
+    for (size_t i = 0; i < self->blocks.length; i++) {
+        memset(self->blocks.data[i]->marks, 0, sizeof(self->blocks.data[i]->marks));
+    }
+}
+
+// Scans gray objects until none are left, returns F if the deadline passed first
+static Owl_Boolean owl_gc_drain(Owl_GC *self, const uint64_t deadline) {
+    size_t scanned = 0;
+    while (self->mark_stack.length > 0) {
+        owl_gc_scan(self, NULL, self->mark_stack.data[--self->mark_stack.length]);
+        if (++scanned % OWL_GC_STEP_CHECK == 0 && owl_gc_now_us() >= deadline) {
+            return F;
+        }
+    }
+    return T;
+}
+
+void owl_gc_mark(Owl_GC *self) {
+    owl_gc_begin_mark(self);
+    const uint64_t started = owl_gc_now_ns();
+    if (self->mark_pool != NULL) {
+        owl_gc_mark_parallel(self);
+    } else {
+        owl_gc_shade_roots(self);
+        owl_gc_drain(self, UINT64_MAX);
+    }
+    self->cycle.mark_ns = owl_gc_now_ns() - started;
+    owl_gc_end_mark(self);
+}
+
+static void owl_gc_finish_mark(Owl_GC *self) {
+    // Nursery survivors come out gray, and roots added since the cycle
+    // started have never been shaded
+    owl_gc_minor(self);
+    owl_gc_shade_roots(self);
+    owl_gc_drain(self, UINT64_MAX);
+    owl_gc_end_mark(self);
+}
+
+Owl_Boolean owl_gc_step(Owl_GC *self, const uint64_t budget_us) {
+    const uint64_t now = owl_gc_now_us();
+    const uint64_t deadline = (budget_us > UINT64_MAX - now ? UINT64_MAX : now + budget_us);
+    for (;;) {
+        switch (self->phase) {
+            case OWL_GC_IDLE: {
+                owl_gc_begin_mark(self);
+                const uint64_t started = owl_gc_now_ns();
+                owl_gc_shade_roots(self);
+                self->phase = OWL_GC_MARKING;
+                self->cycle.mark_ns += owl_gc_now_ns() - started;
+                break;
+            }
+            case OWL_GC_MARKING: {
+                const uint64_t started = owl_gc_now_ns();
+                const Owl_Boolean drained = owl_gc_drain(self, deadline);
+                if (drained == T) {
+                    owl_gc_finish_mark(self);
+                }
+                self->cycle.mark_ns += owl_gc_now_ns() - started;
+                if (drained == F) {
+                    return F;
+                }
+                break;
+            }
+            case OWL_GC_MARKED:
+                if (self->compact == T) {
+                    owl_gc_compact(self);
+                } else {
+                    owl_gc_sweep(self);
+                }
+                break;
+            case OWL_GC_SWEEPING:
+                for (size_t i = 0; i < self->blocks.length; i++) {
+                    if (__atomic_load_n(&self->blocks.data[i]->swept, __ATOMIC_ACQUIRE) == T) continue;
+                    owl_gc_ensure_swept(self, self->blocks.data[i]);
+                    owl_gc_sweep_progress(self);
+                    if (self->phase == OWL_GC_SWEEPING && owl_gc_now_us() >= deadline) {
+                        return F;
+                    }
+                }
+                owl_gc_sweep_progress(self);
+                return T;
+        }
+        if (self->phase == OWL_GC_IDLE) {
+            return T;
+        }
+        if (owl_gc_now_us() >= deadline) {
+            return F;
+        }
+    }
+}
+
+static void *owl_gc_sweeper_thread(void *arg) {
+    Owl_GC_Sweeper *sweeper = arg;
+    size_t generation = 0;
+    pthread_mutex_lock(&sweeper->lock);
+    for (;;) {
+        while (sweeper->generation == generation && sweeper->stop == F) {
+            pthread_cond_wait(&sweeper->wake, &sweeper->lock);
+        }
+        if (sweeper->stop == T) break;
+        generation = sweeper->generation;
+        pthread_mutex_unlock(&sweeper->lock);
+
+        for (size_t i = 0; i < sweeper->length; i++) {
+            Owl_GC_Block *block = sweeper->blocks[i];
+            if (__atomic_load_n(&block->swept, __ATOMIC_ACQUIRE) == T) continue;
+            if (__atomic_exchange_n(&block->claimed, T, __ATOMIC_ACQ_REL) == F) {
+                owl_gc_sweep_block(sweeper->gc, block);
+            }
+        }
+
+        pthread_mutex_lock(&sweeper->lock);
+        sweeper->busy = F;
+        pthread_cond_broadcast(&sweeper->idle);
+    }
+    pthread_mutex_unlock(&sweeper->lock);
+    return NULL;
+}
+
+static Owl_GC_Sweeper *owl_gc_sweeper_new(const Owl_Alloc alloc) {
+    Owl_GC_Sweeper *sweeper = OWL_NEW(alloc, sizeof(Owl_GC_Sweeper));
+    if (sweeper == NULL) {
+        fprintf(stderr, "Failed to allocate sweeper\n");
+        exit(1);
+    }
+    sweeper->gc = NULL;
+    sweeper->generation = 0;
+    sweeper->busy = F;
+    sweeper->stop = F;
+    sweeper->blocks = NULL;
+    sweeper->length = 0;
+    sweeper->capacity = 0;
+    pthread_mutex_init(&sweeper->lock, NULL);
+    pthread_cond_init(&sweeper->wake, NULL);
+    pthread_cond_init(&sweeper->idle, NULL);
+    if (pthread_create(&sweeper->thread, NULL, owl_gc_sweeper_thread, sweeper) != 0) {
+        fprintf(stderr, "Failed to start sweeper thread\n");
+        exit(1);
+    }
+    return sweeper;
+}
+
+// Must be called with the sweeper lock held
+static void owl_gc_sweeper_wait(Owl_GC_Sweeper *sweeper) {
+    while (sweeper->busy == T) {
+        pthread_cond_wait(&sweeper->idle, &sweeper->lock);
+    }
+}
+
+static void owl_gc_sweeper_free(const Owl_Alloc alloc, Owl_GC_Sweeper *sweeper) {
+    pthread_mutex_lock(&sweeper->lock);
+    owl_gc_sweeper_wait(sweeper);
+    sweeper->stop = T;
+    pthread_cond_signal(&sweeper->wake);
+    pthread_mutex_unlock(&sweeper->lock);
+    pthread_join(sweeper->thread, NULL);
+
+    pthread_mutex_destroy(&sweeper->lock);
+    pthread_cond_destroy(&sweeper->wake);
+    pthread_cond_destroy(&sweeper->idle);
+    if (sweeper->blocks != NULL) {
+        OWL_DEL(alloc, sweeper->blocks);
+    }
+    OWL_DEL(alloc, sweeper);
+}
+
+// Hands every unswept block to the sweeper thread
+static void owl_gc_sweeper_start(Owl_GC *self) {
+    Owl_GC_Sweeper *sweeper = self->sweeper;
+    if (sweeper->capacity < self->blocks.length) {
+        if (sweeper->blocks != NULL) {
+            OWL_DEL(self->alloc, sweeper->blocks);
+        }
+        sweeper->blocks = OWL_NEW(self->alloc, sizeof(Owl_GC_Block *) * self->blocks.capacity);
+        if (sweeper->blocks == NULL) {
+            fprintf(stderr, "Out of memory\n");
+            exit(1);
+        }
+        sweeper->capacity = self->blocks.capacity;
+    }
+    sweeper->length = 0;
+    for (size_t i = 0; i < self->blocks.length; i++) {
+        if (self->blocks.data[i]->swept == F) {
+            sweeper->blocks[sweeper->length++] = self->blocks.data[i];
+        }
+    }
+    sweeper->gc = self;
+    sweeper->generation++;
+    sweeper->busy = T;
+    pthread_cond_signal(&sweeper->wake);
+}
+
+void owl_gc_safepoint(Owl_GC *self) {
+    const Owl_Boolean minor = (self->young_bytes >= OWL_GC_NURSERY_SIZE ? T : F);
+    const Owl_Boolean major = (self->phase != OWL_GC_IDLE || self->live_bytes + self->allocated >= self->threshold ? T : F);
+    if (minor == F && major == F) return;
+
+    const uint64_t started = owl_gc_now_ns();
+    if (minor == T) {
+        owl_gc_minor(self);
+    }
+    if (major == T) {
+        // A zero budget runs the rest of the cycle in one pause
+        owl_gc_step(self, (self->step_budget_us == 0 ? UINT64_MAX : self->step_budget_us));
+    }
+    owl_gc_histogram_add(&self->stats.pause, owl_gc_now_ns() - started);
 }
 
 void owl_gc_sweep(Owl_GC *self) {
-    Owl_GC_Header **current = &self->heap;
-    while (*current != NULL) {
-        Owl_GC_Header *header = *current;
-        if (header->marked == F && header->pinned == F) {
-            *current = header->next;
-            self->alloc.del(self->alloc.state, header);
+    if (self->phase != OWL_GC_MARKED) return;
+
+    // The previous pass may still be walking its block list
+    if (self->sweeper != NULL) {
+        pthread_mutex_lock(&self->sweeper->lock);
+        owl_gc_sweeper_wait(self->sweeper);
+    }
+
+    self->unswept = 0;
+    for (size_t i = 0; i < self->blocks.length; i++) {
+        if (self->blocks.data[i]->young == F) {
+            self->blocks.data[i]->swept = F;
+            self->blocks.data[i]->claimed = F;
+            self->unswept++;
+        }
+    }
+    for (size_t i = 0; i < OWL_GC_SPACE_COUNT; i++) {
+        self->spaces[i].cursor = self->spaces[i].first;
+    }
+    self->phase = (self->unswept > 0 ? OWL_GC_SWEEPING : OWL_GC_IDLE);
+    if (self->phase == OWL_GC_IDLE) {
+        owl_gc_end_cycle(self);
+    }
+
+    if (self->sweeper != NULL) {
+        if (self->phase == OWL_GC_SWEEPING) {
+            owl_gc_sweeper_start(self);
+        }
+        pthread_mutex_unlock(&self->sweeper->lock);
+    }
+}
+
+void owl_gc_finish_sweep(Owl_GC *self) {
+    if (self->phase != OWL_GC_SWEEPING) return;
+    for (size_t i = 0; i < self->blocks.length; i++) {
+        owl_gc_ensure_swept(self, self->blocks.data[i]);
+    }
+    owl_gc_sweep_progress(self);
+}
+
+static void owl_gc_update_fields(const Owl_GC *self, Owl_Object *object) {
+    switch (OWL_TYPE(object)) {
+        case OWL_LIST:
+            object->value = owl_gc_forwarded(self, object->value);
+            object->next = owl_gc_forwarded(self, object->next);
+            break;
+        case OWL_ROPE:
+            object->rope_left = owl_gc_forwarded(self, object->rope_left);
+            object->rope_right = owl_gc_forwarded(self, object->rope_right);
+            break;
+        case OWL_DICT:
+            for (size_t i = 0; i < object->dict_capacity; i++) {
+                Owl_DictSlot *slot = &object->dict_slots[i];
+                if (slot->distance == 0) continue;
+                slot->key = owl_gc_forwarded(self, slot->key);
+                slot->value = owl_gc_forwarded(self, slot->value);
+            }
+            break;
+        case OWL_ARRAY:
+            for (size_t i = 0; i < object->length; i++) {
+                object->array[i] = owl_gc_forwarded(self, object->array[i]);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+// Pinned objects and roots, which the host may hold on to, stay put
+static Owl_Boolean owl_gc_is_fixed(const uint64_t word) {
+    return ((word & OWL_GC_LIVE_BIT) != 0 && (word & (OWL_GC_PINNED_BIT | OWL_GC_RETAINED_BIT)) != 0 ? T : F);
+}
+
+// Finalizes the dead objects of a space and gives every movable survivor
+// the next free slot counting from the start of the space. Survivors only
+// ever move towards the start, so the order they were allocated in holds.
+static void owl_gc_plan_space(Owl_GC *self, const Owl_GC_Space *space) {
+    Owl_GC_Block *to = space->first;
+    size_t to_slot = 0;
+    for (Owl_GC_Block *block = space->first; block != NULL; block = block->next) {
+        for (size_t i = 0; i < block->slot_count; i++) {
+            Owl_GC_Header *slot = owl_gc_slot(block, i);
+            const uint64_t word = slot->word;
+            if ((word & OWL_GC_LIVE_BIT) == 0) continue;
+            const Owl_Boolean marked = ((block->marks[i / 64] >> (i % 64)) & 1) != 0 ? T : F;
+            if (marked == F && (word & OWL_GC_PINNED_BIT) == 0) {
+                owl_gc_finalize(self, OWL_GC_OBJECT_FROM_HEADER(slot));
+                slot->word = word & OWL_GC_LOCATION_MASK;
+                self->cycle.freed_objects++;
+                self->cycle.freed_bytes += block->slot_size;
+                continue;
+            }
+            if (owl_gc_is_fixed(word) == T) continue;
+
+            while (owl_gc_is_fixed(owl_gc_slot(to, to_slot)->word) == T) {
+                if (++to_slot == to->slot_count) {
+                    to = to->next;
+                    to_slot = 0;
+                }
+            }
+            slot->word = (word & ~OWL_GC_LOCATION_MASK) | owl_gc_location(to, to_slot);
+            if (++to_slot == to->slot_count) {
+                to = to->next;
+                to_slot = 0;
+            }
+        }
+    }
+}
+
+// Moves the survivors of a space to the slots planned for them, every
+// slot they move to was either free or already vacated
+static void owl_gc_slide_space(const Owl_GC *self, const Owl_GC_Space *space) {
+    for (Owl_GC_Block *block = space->first; block != NULL; block = block->next) {
+        for (size_t i = 0; i < block->slot_count; i++) {
+            Owl_GC_Header *slot = owl_gc_slot(block, i);
+            if (OWL_GC_IS_LIVE(slot) == F) continue;
+            Owl_GC_Header *to = OWL_GC_GET_HEADER(owl_gc_forwarded(self, OWL_GC_OBJECT_FROM_HEADER(slot)));
+            if (to == slot) continue;
+            memcpy(to, slot, block->slot_size);
+            slot->word = owl_gc_location(block, i);
+        }
+    }
+}
+
+// Drops a block from the table, the last block takes over its index
+static void owl_gc_remove_block(Owl_GC *self, Owl_GC_Block *block) {
+    Owl_GC_Block *last = self->blocks.data[--self->blocks.length];
+    if (last != block) {
+        last->index = block->index;
+        self->blocks.data[last->index] = last;
+        const size_t used = (last->young == T ? last->bump : last->slot_count);
+        for (size_t i = 0; i < used; i++) {
+            Owl_GC_Header *slot = owl_gc_slot(last, i);
+            slot->word = (slot->word & ~OWL_GC_LOCATION_MASK) | owl_gc_location(last, i);
+        }
+    }
+    OWL_DEL(self->alloc, block);
+}
+
+// Rebuilds the free lists and mark bits of a compacted space and releases
+// the blocks left empty at its end
+static void owl_gc_rebuild_space(Owl_GC *self, Owl_GC_Space *space) {
+    Owl_GC_Block *block = space->first;
+    space->first = NULL;
+    space->last = NULL;
+    while (block != NULL) {
+        Owl_GC_Block *next = block->next;
+        block->free_list = NULL;
+        block->live = 0;
+        memset(block->marks, 0, sizeof(block->marks));
+        for (size_t i = block->slot_count; i-- > 0;) {
+            Owl_GC_Header *slot = owl_gc_slot(block, i);
+            if (OWL_GC_IS_LIVE(slot)) {
+                block->marks[i / 64] |= (uint64_t)1 << (i % 64);
+                block->live++;
+                continue;
+            }
+            *(Owl_GC_Header **)(slot + 1) = block->free_list;
+            block->free_list = slot;
+        }
+        block->swept = T;
+        block->claimed = T;
+        if (block->live > 0) {
+            owl_gc_link_block(&space->first, &space->last, block);
         } else {
-            header->marked = F;
-            current = &header->next;
+            owl_gc_remove_block(self, block);
+        }
+        block = next;
+    }
+    space->cursor = space->first;
+}
+
+void owl_gc_compact(Owl_GC *self) {
+    if (self->phase != OWL_GC_MARKED) return;
+    const uint64_t started = owl_gc_now_ns();
+
+    if (self->sweeper != NULL) {
+        pthread_mutex_lock(&self->sweeper->lock);
+        owl_gc_sweeper_wait(self->sweeper);
+    }
+
+    // Whatever was allocated since marking is born marked, emptying the
+    // nursery leaves the old space as the only place holding objects
+    owl_gc_minor(self);
+    for (size_t i = 0; i < self->root_length; i++) {
+        if (self->roots[i] != NULL) {
+            self->roots[i]->word |= OWL_GC_RETAINED_BIT;
+        }
+    }
+
+    for (size_t i = 0; i < OWL_GC_SPACE_COUNT; i++) {
+        owl_gc_plan_space(self, &self->spaces[i]);
+    }
+    for (size_t i = 0; i < self->blocks.length; i++) {
+        Owl_GC_Block *block = self->blocks.data[i];
+        if (block->young == T) continue;
+        for (size_t j = 0; j < block->slot_count; j++) {
+            Owl_GC_Header *slot = owl_gc_slot(block, j);
+            if (OWL_GC_IS_LIVE(slot) && owl_gc_has_fields(OWL_GC_OBJECT_FROM_HEADER(slot)) == T) {
+                owl_gc_update_fields(self, OWL_GC_OBJECT_FROM_HEADER(slot));
+            }
         }
     }
+    owl_gc_run_scanners(self, OWL_GC_VISIT_COMPACT);
+    for (size_t i = 0; i < OWL_GC_SPACE_COUNT; i++) {
+        owl_gc_slide_space(self, &self->spaces[i]);
+    }
+
+    for (size_t i = 0; i < self->root_length; i++) {
+        if (self->roots[i] != NULL) {
+            self->roots[i]->word &= ~OWL_GC_RETAINED_BIT;
+        }
+    }
+    for (size_t i = 0; i < OWL_GC_SPACE_COUNT; i++) {
+        owl_gc_rebuild_space(self, &self->spaces[i]);
+    }
+
+    self->unswept = 0;
+    self->phase = OWL_GC_IDLE;
+    if (self->sweeper != NULL) {
+        pthread_mutex_unlock(&self->sweeper->lock);
+    }
+    self->cycle.sweep_ns = owl_gc_now_ns() - started;
+    owl_gc_end_cycle(self);
 }
 
 void owl_gc_deinit(Owl_GC *gc) {
+    for (size_t i = 0; i < gc->symbols.capacity; i++) {
+        Owl_Symbol *symbol = (gc->symbols.slots[i] != NULL ? &gc->symbols.slots[i]->symbol : NULL);
+        if (symbol != NULL && symbol->data != symbol->bytes) {
+            OWL_DEL(gc->alloc, symbol->data);
+        }
+    }
+    if (gc->symbols.slots != NULL) {
+        OWL_DEL(gc->alloc, gc->symbols.slots);
+    }
+    gc->symbols.length = 0;
+    gc->symbols.capacity = 0;
+
+    if (gc->sweeper != NULL) {
+        owl_gc_sweeper_free(gc->alloc, gc->sweeper);
+        gc->sweeper = NULL;
+    }
+
+    for (size_t i = 0; i < gc->blocks.length; i++) {
+        Owl_GC_Block *block = gc->blocks.data[i];
+        const size_t used = (block->young == T ? block->bump : block->slot_count);
+        for (size_t j = 0; j < used; j++) {
+            Owl_GC_Header *slot = owl_gc_slot(block, j);
+            if (OWL_GC_IS_LIVE(slot)) {
+                owl_gc_finalize(gc, OWL_GC_OBJECT_FROM_HEADER(slot));
+            }
+        }
+        OWL_DEL(gc->alloc, block);
+    }
+    if (gc->blocks.data != NULL) {
+        OWL_DEL(gc->alloc, gc->blocks.data);
+        gc->blocks.data = NULL;
+    }
+    gc->blocks.length = 0;
+    gc->blocks.capacity = 0;
+
+    owl_gc_worklist_free(gc->alloc, &gc->mark_stack);
+    owl_gc_worklist_free(gc->alloc, &gc->remembered);
+    owl_gc_worklist_free(gc->alloc, &gc->young_pinned);
+    owl_gc_worklist_free(gc->alloc, &gc->young_finalizable);
+    owl_gc_worklist_free(gc->alloc, &gc->promoted);
+
+    if (gc->mark_pool != NULL) {
+        owl_gc_pool_free(gc->alloc, gc->mark_pool);
+        gc->mark_pool = NULL;
+    }
+
+    if (gc->scanners.data != NULL) {
+        OWL_DEL(gc->alloc, gc->scanners.data);
+        gc->scanners.data = NULL;
+    }
+    gc->scanners.length = 0;
+    gc->scanners.capacity = 0;
+
     OWL_DEL(gc->alloc, gc->roots);
     gc->root_length = 0;
     gc->root_capacity = 0;
-    Owl_GC_Header *current = gc->heap;
-    while (current != NULL) {
-        Owl_GC_Header *header = current;
-        current = current->next;
-        free(header);
+}
+
+void owl_gc_pin(Owl_GC *self, Owl_Object *object) {
+    __atomic_fetch_or(&OWL_GC_GET_HEADER(object)->word, OWL_GC_PINNED_BIT, __ATOMIC_RELAXED);
+    if (owl_gc_block_of(self, object)->young == T) {
+        owl_gc_worklist_push(self, &self->young_pinned, object);
     }
 }
 
-void owl_gc_pin(Owl_Object *object) {
-    OWL_GC_GET_HEADER(object)->pinned = T;
+Owl_GC_Stats owl_gc_stats(const Owl_GC *self) {
+    return self->stats;
 }
 
-Owl_Object *owl_new_symbol(Owl_GC *self, const char *cstr) {
-    Owl_Object *s = owl_gc_new(self, OWL_SYMBOL);
-    s->symbol.data = (char *) (cstr);
-    s->symbol.length = strlen(cstr);
-    s->symbol.owned = false;
+void owl_gc_on_cycle(Owl_GC *self, const owl_gc_cycle_callback callback, void *context) {
+    self->on_cycle.callback = callback;
+    self->on_cycle.context = context;
+}
+
+static size_t owl_symbol_slot(Owl_Object **slots, const size_t capacity, const uint32_t hash, const char *data, const size_t length) {
+    size_t index = hash & (capacity - 1);
+    while (slots[index] != NULL) {
+        const Owl_Symbol *symbol = &slots[index]->symbol;
+        if (symbol->hash == hash && symbol->length == length && memcmp(symbol->data, data, length) == 0) {
+            break;
+        }
+        index = (index + 1) & (capacity - 1);
+    }
+    return index;
+}
+
+static void owl_symbol_table_grow(Owl_GC *self) {
+    const size_t capacity = (self->symbols.capacity == 0 ? OWL_SYMBOL_TABLE_CAPACITY : self->symbols.capacity * 2);
+    Owl_Object **slots = OWL_NEW(self->alloc, sizeof(Owl_Object *) * capacity);
+    if (slots == NULL) {
+        fprintf(stderr, "Failed to allocate symbol table\n");
+        exit(1);
+    }
+    memset(slots, 0, sizeof(Owl_Object *) * capacity);
+
+    for (size_t i = 0; i < self->symbols.capacity; i++) {
+        Owl_Object *symbol = self->symbols.slots[i];
+        if (symbol == NULL) continue;
+        slots[owl_symbol_slot(slots, capacity, symbol->symbol.hash, symbol->symbol.data, symbol->symbol.length)] = symbol;
+    }
+    if (self->symbols.slots != NULL) {
+        OWL_DEL(self->alloc, self->symbols.slots);
+    }
+    self->symbols.slots = slots;
+    self->symbols.capacity = capacity;
+}
+
+Owl_Object *owl_intern_symbol(Owl_GC *self, const char *data, const size_t length) {
+    if ((self->symbols.length + 1) * 2 > self->symbols.capacity) {
+        owl_symbol_table_grow(self);
+    }
+
+    const uint32_t hash = owl_string_hash(data, length);
+    const size_t index = owl_symbol_slot(self->symbols.slots, self->symbols.capacity, hash, data, length);
+    if (self->symbols.slots[index] != NULL) {
+        return self->symbols.slots[index];
+    }
+
+    // Symbols never die, so they skip the nursery
+    Owl_Object *s = owl_gc_new_old(self, OWL_SYMBOL);
+    owl_gc_count_new(self, OWL_SYMBOL);
+
+    char *name = s->symbol.bytes;
+    if (length > OWL_STRING_SMALL) {
+        name = OWL_NEW(self->alloc, length + 1);
+        if (name == NULL) {
+            fprintf(stderr, "Out of memory\n");
+            exit(1);
+        }
+    }
+    memcpy(name, data, length);
+    name[length] = '\0';
+    s->symbol.data = name;
+    s->symbol.length = length;
+    s->symbol.hash = hash;
+    s->symbol.id = (uint32_t)self->symbols.length;
+    owl_gc_pin(self, s);
+
+    self->symbols.slots[index] = s;
+    self->symbols.length++;
     return s;
 }
 
+Owl_Object *owl_new_symbol(Owl_GC *self, const char *cstr) {
+    return owl_intern_symbol(self, cstr, strlen(cstr));
+}
+
 Owl_Object *owl_new_number(Owl_GC *self, const double value) {
     Owl_Object *n = owl_gc_new(self, OWL_NUMBER);
     n->number = value;
     return n;
 }
 
+Owl_Object *owl_new_string(Owl_GC *self, const char *data, const size_t length) {
+    Owl_Object *s = owl_gc_new(self, OWL_STRING);
+    s->string = owl_string_from(data, length, self->alloc);
+    return s;
+}
+
 Owl_Object *owl_new_list(Owl_GC *self) {
     Owl_Object *list = owl_gc_new(self, OWL_LIST);
     list->next = NULL;
@@ -169,8 +1719,9 @@ Owl_Object *owl_new_list(Owl_GC *self) {
 
 Owl_Object *owl_new_nothing(Owl_GC *self) {
     if (self->nothing == NULL) {
-        self->nothing = owl_gc_new(self, OWL_NOTHING);
-        owl_gc_pin(self->nothing);
+        self->nothing = owl_gc_new_old(self, OWL_NOTHING);
+        owl_gc_count_new(self, OWL_NOTHING);
+        owl_gc_pin(self, self->nothing);
     }
     return self->nothing;
 }
@@ -183,3 +1734,21 @@ Owl_Object *owl_new_array(Owl_GC *self, size_t length) {
     array->capacity = length;
     return array;
 }
+
+Owl_Object *owl_new_f64_array(Owl_GC *self, const size_t length) {
+    double *data = OWL_NEW(self->alloc, sizeof(double) * (length == 0 ? 1 : length));
+    if (data == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+    memset(data, 0, sizeof(double) * length);
+    Owl_Object *array = owl_gc_new(self, OWL_F64_ARRAY);
+    array->f64 = data;
+    array->f64_length = length;
+    return array;
+}
+
+void owl_array_set(Owl_GC *self, Owl_Object *array, const size_t index, Owl_Object *value) {
+    array->array[index] = value;
+    owl_gc_write_barrier(self, array, value);
+}
@@ -4,10 +4,10 @@
 #include "objects.h"
 #include "alloc.h"
 
+// Objects live in fixed size slots inside blocks, the header is just the
+// packed word described by OWL_OBJECT_HEADER_WORD
 struct Owl_GC_Header {
-    struct Owl_GC_Header *next;
-    Owl_Boolean marked;
-    Owl_Boolean pinned;
+    uint64_t word;
 };
 
 typedef struct Owl_GC_Header Owl_GC_Header;
@@ -23,8 +23,286 @@ typedef struct Owl_GC_Header Owl_GC_Header;
 #define OWL_ROOT_COUNT \
     16
 
+// Initial number of entries in the mark stack and the other GC worklists,
+// they double when full
+#define OWL_MARK_STACK_CAPACITY \
+    256
+
+// Initial size of the symbol table, it doubles once half full
+#define OWL_SYMBOL_TABLE_CAPACITY \
+    64
+
+// Default pause budget for incremental steps taken by the evaluator
+#define OWL_GC_STEP_BUDGET_US \
+    500
+
+// Gray objects scanned between clock reads during an incremental step
+#define OWL_GC_STEP_CHECK \
+    256
+
+// A parallel marker offers half of its private stack to idle threads once
+// it holds this many entries
+#define OWL_GC_SHARE_THRESHOLD \
+    64
+
+// Young bytes allocated before a safepoint runs a minor collection
+#define OWL_GC_NURSERY_SIZE \
+    (2 * 1024 * 1024)
+
+// Old space size below which safepoints never start a full collection
+#define OWL_GC_MIN_THRESHOLD \
+    (4 * 1024 * 1024)
+
+// Default ratio between the old space size that triggers a collection and
+// what survived the previous one
+#define OWL_GC_GROWTH_FACTOR \
+    2.0
+
+// Duration histograms have one bucket per power of two microseconds,
+// bucket i counts durations under 2^i us and the last one the rest too
+#define OWL_GC_HISTOGRAM_BUCKETS \
+    24
+
+// Number of object types, for the tables indexed by Owl_ObjectType
+#define OWL_GC_TYPE_COUNT \
+    (OWL_ROPE + 1)
+
+// Bytes of slot storage in each heap block
+#define OWL_GC_BLOCK_SIZE \
+    (32 * 1024)
+
+// Slots are multiples of 8 bytes from 16 up to this size, one space each
+#define OWL_GC_MAX_SLOT_SIZE \
+    72
+
+#define OWL_GC_SPACE_COUNT \
+    (OWL_GC_MAX_SLOT_SIZE / 8 - 1)
+
+#define OWL_GC_MAX_SLOTS \
+    (OWL_GC_BLOCK_SIZE / 16)
+
+#define OWL_GC_MARK_WORDS \
+    (OWL_GC_MAX_SLOTS / 64)
+
+// Header word bits above the type byte. Every slot, free or not, also
+// records its block and slot index so mark bits can be found directly.
+#define OWL_GC_LIVE_BIT \
+    ((uint64_t)1 << 8)
+
+#define OWL_GC_PINNED_BIT \
+    ((uint64_t)1 << 9)
+
+// Young object that was copied out of the nursery, its first payload word
+// holds the new address
+#define OWL_GC_FORWARDED_BIT \
+    ((uint64_t)1 << 10)
+
+// Old object already in the remembered set
+#define OWL_GC_REMEMBERED_BIT \
+    ((uint64_t)1 << 11)
+
+// Young object kept in place by a minor collection, its block is promoted
+#define OWL_GC_RETAINED_BIT \
+    ((uint64_t)1 << 12)
+
+// Blocks are indexed by 20 bits, which caps the heap at 32 GiB of blocks
+#define OWL_GC_BLOCK_SHIFT \
+    13
+
+#define OWL_GC_BLOCK_MASK \
+    ((uint64_t)0xfffff)
+
+#define OWL_GC_SLOT_SHIFT \
+    33
+
+// Wide enough for OWL_GC_MAX_SLOTS
+#define OWL_GC_SLOT_MASK \
+    ((uint64_t)0x7ff)
+
+// The top 20 bits hold an identity hash picked at allocation. It moves
+// with the header when the object is copied or compacted, so objects
+// compared by identity can hash without using their address.
+#define OWL_GC_HASH_SHIFT \
+    44
+
+#define OWL_GC_HASH_MASK \
+    ((uint64_t)0xfffff)
+
+#define OWL_GC_HASH_BITS \
+    (OWL_GC_HASH_MASK << OWL_GC_HASH_SHIFT)
+
+#define OWL_GC_IDENTITY_HASH(o) \
+    ((uint32_t)((OWL_GC_GET_HEADER((o))->word >> OWL_GC_HASH_SHIFT) & OWL_GC_HASH_MASK))
+
+#define OWL_GC_LOCATION_MASK \
+    ((OWL_GC_BLOCK_MASK << OWL_GC_BLOCK_SHIFT) | (OWL_GC_SLOT_MASK << OWL_GC_SLOT_SHIFT))
+
+#define OWL_GC_BLOCK_OF(word) \
+    ((size_t)(((word) >> OWL_GC_BLOCK_SHIFT) & OWL_GC_BLOCK_MASK))
+
+#define OWL_GC_SLOT_OF(word) \
+    ((size_t)(((word) >> OWL_GC_SLOT_SHIFT) & OWL_GC_SLOT_MASK))
+
+#define OWL_GC_IS_LIVE(h) \
+    (((h)->word & OWL_GC_LIVE_BIT) != 0)
+
 #define OWL_IS_PINNED(o) \
-    (OWL_GC_GET_HEADER((o))->pinned == T)
+    ((OWL_GC_GET_HEADER((o))->word & OWL_GC_PINNED_BIT) != 0)
+
+struct Owl_GC_Block {
+    struct Owl_GC_Block *next;
+    size_t index;
+    size_t slot_size;
+    size_t slot_count;
+    size_t live;
+    Owl_Boolean swept;
+    // Set by whichever thread sweeps the block first
+    Owl_Boolean claimed;
+    // Nursery blocks are bump allocated and never swept
+    Owl_Boolean young;
+    size_t bump;
+    size_t retained;
+    Owl_GC_Header *free_list;
+    // Side table of mark bits, one per slot
+    uint64_t marks[OWL_GC_MARK_WORDS];
+    char *slots;
+};
+
+typedef struct Owl_GC_Block Owl_GC_Block;
+
+// All blocks holding one slot size, allocation walks them from cursor.
+// The nursery blocks of the same size are kept on their own list.
+struct Owl_GC_Space {
+    Owl_GC_Block *first;
+    Owl_GC_Block *last;
+    Owl_GC_Block *cursor;
+
+    Owl_GC_Block *young_first;
+    Owl_GC_Block *young_last;
+    Owl_GC_Block *nursery;
+};
+
+typedef struct Owl_GC_Space Owl_GC_Space;
+
+enum Owl_GC_Phase {
+    OWL_GC_IDLE,
+    // Incremental marking in progress, the mark stack holds the gray objects
+    // and the write barrier shades white objects stored into marked ones
+    OWL_GC_MARKING,
+    // Mark bits are valid until owl_gc_sweep, new objects are born marked
+    OWL_GC_MARKED,
+    // Some blocks are still unswept, owl_gc_new sweeps them on demand
+    OWL_GC_SWEEPING
+};
+
+typedef enum Owl_GC_Phase Owl_GC_Phase;
+
+struct Owl_GC_Worklist {
+    Owl_Object **data;
+    size_t length;
+    size_t capacity;
+};
+
+typedef struct Owl_GC_Worklist Owl_GC_Worklist;
+
+struct Owl_GC_Options {
+    // Threads taking part in owl_gc_mark, the calling thread included
+    size_t mark_threads;
+    // Sweep on a helper thread after owl_gc_sweep returns. Dead strings and
+    // arrays are then freed from that thread, so the allocator has to be
+    // thread safe, which the default one is.
+    Owl_Boolean background_sweep;
+    // Larger values collect less often and let the heap grow further,
+    // anything not above 1 selects OWL_GC_GROWTH_FACTOR
+    double growth_factor;
+    // Finish the collections started by safepoints with owl_gc_compact
+    // rather than owl_gc_sweep
+    Owl_Boolean compact;
+};
+
+typedef struct Owl_GC_Options Owl_GC_Options;
+
+struct Owl_GC_Histogram {
+    size_t count;
+    uint64_t total_ns;
+    uint64_t max_ns;
+    size_t buckets[OWL_GC_HISTOGRAM_BUCKETS];
+};
+
+typedef struct Owl_GC_Histogram Owl_GC_Histogram;
+
+// What one full collection did, reported once all of it has been swept
+struct Owl_GC_Cycle {
+    size_t number;
+    uint64_t mark_ns;
+    uint64_t sweep_ns;
+    size_t surviving_objects;
+    size_t surviving_bytes;
+    size_t freed_objects;
+    size_t freed_bytes;
+};
+
+typedef struct Owl_GC_Cycle Owl_GC_Cycle;
+
+struct Owl_GC_Stats {
+    // Objects created by the program and their slot sizes, the storage
+    // behind strings and arrays isn't included
+    size_t objects_allocated[OWL_GC_TYPE_COUNT];
+    size_t bytes_allocated[OWL_GC_TYPE_COUNT];
+
+    size_t collections;
+    size_t minor_collections;
+    // Nursery bytes minor collections went through and the part of them
+    // that was copied or promoted, their ratio is the survival rate
+    size_t young_bytes;
+    size_t promoted_bytes;
+    size_t freed_objects;
+    size_t freed_bytes;
+
+    // Marking and sweeping time of each full cycle, and the length of
+    // every pause the collector took at a safepoint
+    Owl_GC_Histogram mark;
+    Owl_GC_Histogram sweep;
+    Owl_GC_Histogram pause;
+
+    Owl_GC_Cycle last;
+};
+
+typedef struct Owl_GC_Stats Owl_GC_Stats;
+
+struct Owl_GC;
+
+// Called on the mutator thread when a cycle's sweep completes, which can
+// be in the middle of an allocation, so it must not allocate GC objects
+typedef void (*owl_gc_cycle_callback)(struct Owl_GC *gc, const Owl_GC_Cycle *cycle, void *context);
+
+// Roots that aren't objects, such as the evaluator's value stack, are
+// reported by a scanner calling owl_gc_visit on every slot it owns
+typedef void (*owl_gc_scanner)(struct Owl_GC *gc, void *context);
+
+struct Owl_GC_Scanner {
+    owl_gc_scanner scan;
+    void *context;
+};
+
+typedef struct Owl_GC_Scanner Owl_GC_Scanner;
+
+enum Owl_GC_Visit {
+    OWL_GC_VISIT_NONE,
+    OWL_GC_VISIT_MINOR,
+    OWL_GC_VISIT_MARK,
+    OWL_GC_VISIT_COMPACT
+};
+
+typedef enum Owl_GC_Visit Owl_GC_Visit;
+
+struct Owl_GC_MarkPool;
+
+typedef struct Owl_GC_MarkPool Owl_GC_MarkPool;
+
+struct Owl_GC_Sweeper;
+
+typedef struct Owl_GC_Sweeper Owl_GC_Sweeper;
 
 struct Owl_GC {
     Owl_Alloc alloc;
@@ -33,33 +311,179 @@ struct Owl_GC {
     size_t root_length;
     size_t root_capacity;
 
-    Owl_GC_Header *heap;
+    struct {
+        Owl_GC_Scanner *data;
+        size_t length;
+        size_t capacity;
+    } scanners;
+    // What owl_gc_visit does with the slots handed to it
+    Owl_GC_Visit visit;
+
+    // Indexed by the block number stored in each header word
+    struct {
+        Owl_GC_Block **data;
+        size_t length;
+        size_t capacity;
+    } blocks;
+
+    Owl_GC_Space spaces[OWL_GC_SPACE_COUNT];
+
+    Owl_GC_Phase phase;
+    size_t unswept;
+    // Longest pause a safepoint allows itself when advancing a cycle, zero
+    // makes safepoints collect in a single stop-the-world pass
+    uint64_t step_budget_us;
+
+    // Old space bytes allocated since the last mark, what that mark found
+    // live, and the total at which safepoints start the next collection
+    double growth_factor;
+    size_t allocated;
+    size_t live_bytes;
+    size_t threshold;
+
+    // Objects marked but not yet scanned, kept between collections
+    Owl_GC_Worklist mark_stack;
+
+    // Old objects that may point into the nursery, filled by the write barrier
+    Owl_GC_Worklist remembered;
+    // Young objects pinned in place and young objects owning memory that
+    // has to be released if they die in the nursery
+    Owl_GC_Worklist young_pinned;
+    Owl_GC_Worklist young_finalizable;
+    // Survivors whose fields still point into the nursery
+    Owl_GC_Worklist promoted;
+    size_t young_bytes;
+
+    Owl_GC_Stats stats;
+    // Totals for the cycle in progress, the sweeper thread adds to them
+    Owl_GC_Cycle cycle;
+    struct {
+        owl_gc_cycle_callback callback;
+        void *context;
+    } on_cycle;
+
+    // Helper threads for owl_gc_mark, NULL when marking on one thread
+    Owl_GC_MarkPool *mark_pool;
+    // Background sweeping thread, NULL when the mutator sweeps lazily
+    Owl_GC_Sweeper *sweeper;
+    Owl_Boolean compact;
+
+    // Open addressed intern table, symbols are pinned and never collected
+    struct {
+        Owl_Object **slots;
+        size_t length;
+        size_t capacity;
+    } symbols;
 
     Owl_Object *nothing;
+
+    // Weyl sequence the identity hashes are taken from
+    uint64_t next_hash;
 };
 
 typedef struct Owl_GC Owl_GC;
 
+// Walks to the end of the list first, build long lists with a builder
 void owl_list_append(Owl_GC *gc, Owl_Object *list, Owl_Object* value);
 
+// Appends in constant time by remembering the last node. The nodes are
+// ordinary unrooted objects, so a builder must not be kept across a
+// collection, root the head and resume with owl_list_builder_from instead.
+struct Owl_ListBuilder {
+    Owl_Object *head;
+    Owl_Object *tail;
+    size_t length;
+};
+
+typedef struct Owl_ListBuilder Owl_ListBuilder;
+
+// Starts a new empty list
+Owl_ListBuilder owl_list_builder(Owl_GC *gc);
+// Continues an existing list, walking it once to find the end
+Owl_ListBuilder owl_list_builder_from(Owl_Object *list);
+void owl_list_builder_append(Owl_GC *gc, Owl_ListBuilder *builder, Owl_Object *value);
+
+Owl_GC_Options owl_gc_default_options(void);
 Owl_GC owl_gc_init(Owl_Alloc alloc);
+Owl_GC owl_gc_init_with(Owl_Alloc alloc, Owl_GC_Options options);
 void owl_gc_deinit(Owl_GC *gc);
 
 void owl_gc_add_root(Owl_GC *gc, Owl_Object *root);
-void owl_gc_pin(Owl_Object *object);
+void owl_gc_remove_root(Owl_GC *gc, Owl_Object *root);
 
+void owl_gc_add_scanner(Owl_GC *self, owl_gc_scanner scanner, void *context);
+void owl_gc_remove_scanner(Owl_GC *self, owl_gc_scanner scanner, void *context);
+// Reports one root slot, the slot is updated if the object moves
+void owl_gc_visit(Owl_GC *self, Owl_Value *slot);
+void owl_gc_pin(Owl_GC *self, Owl_Object *object);
+
+Owl_GC_Stats owl_gc_stats(const Owl_GC *self);
+// Replaces the cycle callback, NULL removes it
+void owl_gc_on_cycle(Owl_GC *self, owl_gc_cycle_callback callback, void *context);
+
+// Bump allocates in the nursery. Young objects that survive a minor
+// collection are copied to the old space unless they are rooted or pinned,
+// so only those addresses stay valid across owl_gc_minor, owl_gc_mark and
+// owl_gc_compact.
 Owl_Object *owl_gc_new(Owl_GC *self, Owl_ObjectType type);
 
-void owl_gc_mark(const Owl_GC *self);
+// Must be called after storing child into a field of parent when the store
+// doesn't go through one of the constructors or mutators below
+void owl_gc_write_barrier(Owl_GC *self, Owl_Object *parent, Owl_Object *child);
+
+Owl_Boolean owl_gc_is_young(const Owl_GC *self, const Owl_Object *object);
+
+// Evacuates the live part of the nursery into the old space, tracing only
+// from the roots, pinned young objects and the remembered set
+void owl_gc_minor(Owl_GC *self);
+
+// Size of the slot holding an object of this type, header included
+size_t owl_gc_object_size(Owl_ObjectType type);
+
+Owl_Boolean owl_gc_is_marked(const Owl_GC *self, const Owl_Object *object);
 
+// Empties the nursery and sweeps whatever the lazy sweeper has left, then
+// clears the mark bitmaps and marks everything reachable from the roots
+void owl_gc_mark(Owl_GC *self);
+
+// Only flags every block as unswept, each block is reclaimed the next time
+// the old space needs a slot from it or by the background sweeper
 void owl_gc_sweep(Owl_GC *self);
 
+void owl_gc_finish_sweep(Owl_GC *self);
+
+// Used instead of owl_gc_sweep after marking. Slides the survivors of each
+// space towards its first block, keeping their order, frees the blocks left
+// empty and leaves the collector idle. Rooted and pinned objects don't move,
+// references from other objects and from scanners are updated.
+void owl_gc_compact(Owl_GC *self);
+
+// Advances an incremental collection by roughly budget_us microseconds,
+// starting a new cycle when idle. Returns T once the cycle has been marked
+// and swept. Marking is finished by a minor collection and a rescan of the
+// roots, whose cost depends on the nursery rather than on the budget.
+Owl_Boolean owl_gc_step(Owl_GC *self, uint64_t budget_us);
+
+// Called where every live value is reachable from the roots and scanners.
+// Runs a minor collection once the nursery is full and starts or advances
+// a full collection once the old space passes gc->threshold.
+void owl_gc_safepoint(Owl_GC *self);
+
 // Constructors
 Owl_Object *owl_new_nothing(Owl_GC *self);
+// Returns the unique symbol with this name, the name is copied
 Owl_Object *owl_new_symbol(Owl_GC *self, const char *cstr);
+Owl_Object *owl_intern_symbol(Owl_GC *self, const char *data, size_t length);
 Owl_Object *owl_new_number(Owl_GC *self, double value);
+// The bytes are copied, short strings need no storage besides the object
+Owl_Object *owl_new_string(Owl_GC *self, const char *data, size_t length);
 Owl_Object *owl_new_list(Owl_GC *self);
 
 Owl_Object *owl_new_array(Owl_GC *self, size_t length);
+// The elements start out as zero
+Owl_Object *owl_new_f64_array(Owl_GC *self, size_t length);
+
+// Mutators, these apply the write barrier
+void owl_array_set(Owl_GC *self, Owl_Object *array, size_t index, Owl_Object *value);
 
 #endif //OWL_GC_H
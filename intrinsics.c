@@ -1,25 +1,112 @@
 #include "intrinsics.h"
 #include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rope.h"
+#include "vector.h"
+
+const Owl_NamedIntrinsic owl_base_intrinsics[] = {
+    { .fn = owl_intrinsic_add, .sym = "+", .pure = T },
+    { .fn = owl_intrinsic_sub, .sym = "-", .pure = T },
+    { .fn = owl_intrinsic_mul, .sym = "*", .pure = T },
+    { .fn = owl_intrinsic_div, .sym = "/", .pure = T },
+    { .fn = owl_intrinsic_echo, .sym = "echo" },
+    { .fn = owl_intrinsic_concat, .sym = "concat", .pure = T },
+};
+
+const size_t owl_base_intrinsics_length = sizeof(owl_base_intrinsics) / sizeof(owl_base_intrinsics[0]);
+
+static Owl_Object *owl_arith_f64_array(const Owl_Value value) {
+    if (!OWL_VALUE_IS_OBJECT(value)) return NULL;
+    Owl_Object *object = OWL_VALUE_AS_OBJECT(value);
+    return (OWL_TYPE(object) == OWL_F64_ARRAY ? object : NULL);
+}
+
+// Folds the arguments left to right. Numbers combine as usual, once an
+// f64 array is involved the result is a new array that numbers are
+// broadcast across and other arrays are combined with element-wise. A
+// single argument is combined with the identity, so (- x) negates.
+static void owl_arith(Owl_GC *gc, Owl_Stack *stack, const Owl_VectorOp op, const double identity) {
+    const size_t count = stack->length;
+    size_t index = (count == 1 ? 0 : 1);
+    double number = identity;
+    Owl_Object *result = NULL;
+
+    if (count > 1) {
+        Owl_Object *array = owl_arith_f64_array(stack->data[0]);
+        if (array != NULL) {
+            result = owl_new_f64_array(gc, array->f64_length);
+            memcpy(result->f64, array->f64, sizeof(double) * array->f64_length);
+        } else {
+            assert(OWL_VALUE_IS_NUMBER(stack->data[0]));
+            number = owl_value_as_number(stack->data[0]);
+        }
+    }
+
+    while (index < count) {
+        const Owl_Value value = stack->data[index];
+        Owl_Object *array = owl_arith_f64_array(value);
+        if (array == NULL) {
+            assert(OWL_VALUE_IS_NUMBER(value));
+            if (result != NULL) {
+                owl_vector_op_scalar(op, result->f64, result->f64, owl_value_as_number(value), result->f64_length);
+            } else {
+                number = owl_vector_apply(op, number, owl_value_as_number(value));
+            }
+        } else if (result == NULL) {
+            result = owl_new_f64_array(gc, array->f64_length);
+            owl_vector_scalar_op(op, result->f64, number, array->f64, array->f64_length);
+        } else {
+            if (array->f64_length != result->f64_length) {
+                fprintf(stderr, "array length mismatch: %zu and %zu\n", result->f64_length, array->f64_length);
+                exit(1);
+            }
+            owl_vector_op(op, result->f64, result->f64, array->f64, result->f64_length);
+        }
+        index++;
+    }
+
+    owl_stack_push(stack, (result != NULL ? OWL_VALUE_OBJECT(result) : owl_value_number(number)), gc->alloc);
+}
 
 void owl_intrinsic_add(Owl_GC *gc, Owl_Stack *stack) {
-  Owl_Object *result = owl_new_number(gc, 0.0);
-  size_t index = 0;
-  while (index < stack->length) {
-      assert(stack->data[index]->type == OWL_NUMBER);
-      result->number += stack->data[index]->number;
-      index++;
-  }
-  owl_stack_push(stack, result, gc->alloc);
+    owl_arith(gc, stack, OWL_VECTOR_ADD, 0.0);
 }
 
 void owl_intrinsic_sub(Owl_GC *gc, Owl_Stack *stack) {
+    owl_arith(gc, stack, OWL_VECTOR_SUB, 0.0);
 }
 
 void owl_intrinsic_mul(Owl_GC *gc, Owl_Stack *stack) {
+    owl_arith(gc, stack, OWL_VECTOR_MUL, 1.0);
 }
 
 void owl_intrinsic_div(Owl_GC *gc, Owl_Stack *stack) {
+    owl_arith(gc, stack, OWL_VECTOR_DIV, 1.0);
 }
 
 void owl_intrinsic_echo(Owl_GC *gc, Owl_Stack *stack) {
 }
+
+// Strings are joined into a rope without copying, other values are
+// converted the way they print
+void owl_intrinsic_concat(Owl_GC *gc, Owl_Stack *stack) {
+    const size_t count = stack->length;
+    Owl_Object *result = NULL;
+    for (size_t i = 0; i < count; i++) {
+        const Owl_Value value = stack->data[i];
+        Owl_Object *piece = (OWL_VALUE_IS_OBJECT(value) ? OWL_VALUE_AS_OBJECT(value) : NULL);
+        if (piece == NULL || (OWL_TYPE(piece) != OWL_STRING && OWL_TYPE(piece) != OWL_ROPE)) {
+            Owl_String printed = owl_value_tostring(value, gc->alloc);
+            piece = owl_new_string(gc, owl_string_data(&printed), printed.length);
+            owl_string_del(&printed, gc->alloc);
+        }
+        result = (result == NULL ? piece : owl_rope_concat(gc, result, piece));
+    }
+    if (result == NULL) {
+        result = owl_new_string(gc, NULL, 0);
+    }
+    owl_stack_push(stack, OWL_VALUE_OBJECT(result), gc->alloc);
+}
@@ -4,18 +4,25 @@
 #include "code.h"
 #include "gc.h"
 
+struct Owl_NamedIntrinsic {
+    const char *sym;
+    Owl_Object *symbol;
+    owl_intrinsic fn;
+    // Same arguments, same result and nothing else happens, so calls with
+    // constant arguments are made once by the compiler
+    Owl_Boolean pure;
+};
+
+typedef struct Owl_NamedIntrinsic Owl_NamedIntrinsic;
+
 void owl_intrinsic_add(Owl_GC *gc, Owl_Stack *stack);
 void owl_intrinsic_sub(Owl_GC *gc, Owl_Stack *stack);
 void owl_intrinsic_mul(Owl_GC *gc, Owl_Stack *stack);
 void owl_intrinsic_div(Owl_GC *gc, Owl_Stack *stack);
 void owl_intrinsic_echo(Owl_GC *gc, Owl_Stack *stack);
+void owl_intrinsic_concat(Owl_GC *gc, Owl_Stack *stack);
 
-static struct { owl_intrinsic fn; const char *sym; } owl_base_intrinsics[] = {
-    { .fn = owl_intrinsic_add, .sym = "+" },
-    { .fn = owl_intrinsic_sub, .sym = "-" },
-    { .fn = owl_intrinsic_mul, .sym = "*" },
-    { .fn = owl_intrinsic_div, .sym = "/" },
-    { .fn = owl_intrinsic_echo, .sym = "echo" },
-};
+extern const Owl_NamedIntrinsic owl_base_intrinsics[];
+extern const size_t owl_base_intrinsics_length;
 
 #endif //OWL_INTRINSICS_H
@@ -0,0 +1,431 @@
+#include "numbers.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Grisu3 (Loitsch, "Printing Floating-Point Numbers Quickly and
+// Accurately with Integers"). Digits come out of a 64 bit approximation
+// scaled by a cached power of ten until they fall inside the rounding
+// interval. The approximation is off by a few units, so the result is
+// only used when those units can't change which digits are shortest and
+// closest, about 0.5% of inputs take the slow exact path instead.
+
+// A 64 bit significand and binary exponent, f * 2^e
+struct Owl_DiyFp {
+    uint64_t f;
+    int e;
+};
+
+typedef struct Owl_DiyFp Owl_DiyFp;
+
+#define OWL_DIYFP_HIDDEN_BIT \
+    ((uint64_t)1 << 52)
+
+// 10^k normalized to a 64 bit significand, for k = -348, -340, ..., 340
+static const Owl_DiyFp owl_cached_powers[] = {
+    {0xfa8fd5a0081c0288u, -1220}, {0xbaaee17fa23ebf76u, -1193}, {0x8b16fb203055ac76u, -1166},
+    {0xcf42894a5dce35eau, -1140}, {0x9a6bb0aa55653b2du, -1113}, {0xe61acf033d1a45dfu, -1087},
+    {0xab70fe17c79ac6cau, -1060}, {0xff77b1fcbebcdc4fu, -1034}, {0xbe5691ef416bd60cu, -1007},
+    {0x8dd01fad907ffc3cu, -980}, {0xd3515c2831559a83u, -954}, {0x9d71ac8fada6c9b5u, -927},
+    {0xea9c227723ee8bcbu, -901}, {0xaecc49914078536du, -874}, {0x823c12795db6ce57u, -847},
+    {0xc21094364dfb5637u, -821}, {0x9096ea6f3848984fu, -794}, {0xd77485cb25823ac7u, -768},
+    {0xa086cfcd97bf97f4u, -741}, {0xef340a98172aace5u, -715}, {0xb23867fb2a35b28eu, -688},
+    {0x84c8d4dfd2c63f3bu, -661}, {0xc5dd44271ad3cdbau, -635}, {0x936b9fcebb25c996u, -608},
+    {0xdbac6c247d62a584u, -582}, {0xa3ab66580d5fdaf6u, -555}, {0xf3e2f893dec3f126u, -529},
+    {0xb5b5ada8aaff80b8u, -502}, {0x87625f056c7c4a8bu, -475}, {0xc9bcff6034c13053u, -449},
+    {0x964e858c91ba2655u, -422}, {0xdff9772470297ebdu, -396}, {0xa6dfbd9fb8e5b88fu, -369},
+    {0xf8a95fcf88747d94u, -343}, {0xb94470938fa89bcfu, -316}, {0x8a08f0f8bf0f156bu, -289},
+    {0xcdb02555653131b6u, -263}, {0x993fe2c6d07b7facu, -236}, {0xe45c10c42a2b3b06u, -210},
+    {0xaa242499697392d3u, -183}, {0xfd87b5f28300ca0eu, -157}, {0xbce5086492111aebu, -130},
+    {0x8cbccc096f5088ccu, -103}, {0xd1b71758e219652cu, -77}, {0x9c40000000000000u, -50},
+    {0xe8d4a51000000000u, -24}, {0xad78ebc5ac620000u, 3}, {0x813f3978f8940984u, 30},
+    {0xc097ce7bc90715b3u, 56}, {0x8f7e32ce7bea5c70u, 83}, {0xd5d238a4abe98068u, 109},
+    {0x9f4f2726179a2245u, 136}, {0xed63a231d4c4fb27u, 162}, {0xb0de65388cc8ada8u, 189},
+    {0x83c7088e1aab65dbu, 216}, {0xc45d1df942711d9au, 242}, {0x924d692ca61be758u, 269},
+    {0xda01ee641a708deau, 295}, {0xa26da3999aef774au, 322}, {0xf209787bb47d6b85u, 348},
+    {0xb454e4a179dd1877u, 375}, {0x865b86925b9bc5c2u, 402}, {0xc83553c5c8965d3du, 428},
+    {0x952ab45cfa97a0b3u, 455}, {0xde469fbd99a05fe3u, 481}, {0xa59bc234db398c25u, 508},
+    {0xf6c69a72a3989f5cu, 534}, {0xb7dcbf5354e9beceu, 561}, {0x88fcf317f22241e2u, 588},
+    {0xcc20ce9bd35c78a5u, 614}, {0x98165af37b2153dfu, 641}, {0xe2a0b5dc971f303au, 667},
+    {0xa8d9d1535ce3b396u, 694}, {0xfb9b7cd9a4a7443cu, 720}, {0xbb764c4ca7a44410u, 747},
+    {0x8bab8eefb6409c1au, 774}, {0xd01fef10a657842cu, 800}, {0x9b10a4e5e9913129u, 827},
+    {0xe7109bfba19c0c9du, 853}, {0xac2820d9623bf429u, 880}, {0x80444b5e7aa7cf85u, 907},
+    {0xbf21e44003acdd2du, 933}, {0x8e679c2f5e44ff8fu, 960}, {0xd433179d9c8cb841u, 986},
+    {0x9e19db92b4e31ba9u, 1013}, {0xeb96bf6ebadf77d9u, 1039}, {0xaf87023b9bf0ee6bu, 1066},
+};
+
+static const uint64_t owl_pow10[] = {
+    1u, 10u, 100u, 1000u, 10000u, 100000u, 1000000u, 10000000u, 100000000u, 1000000000u,
+    10000000000u, 100000000000u, 1000000000000u, 10000000000000u, 100000000000000u,
+    1000000000000000u, 10000000000000000u, 100000000000000000u, 1000000000000000000u,
+    10000000000000000000u,
+};
+
+static Owl_DiyFp owl_diyfp_from(const double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    const int biased = (int)((bits >> 52) & 0x7ff);
+    const uint64_t significand = bits & (OWL_DIYFP_HIDDEN_BIT - 1);
+    if (biased != 0) {
+        return (Owl_DiyFp){.f = significand + OWL_DIYFP_HIDDEN_BIT, .e = biased - 1075};
+    }
+    return (Owl_DiyFp){.f = significand, .e = -1074};
+}
+
+static Owl_DiyFp owl_diyfp_normalize(Owl_DiyFp x) {
+    const int shift = __builtin_clzll(x.f);
+    return (Owl_DiyFp){.f = x.f << shift, .e = x.e - shift};
+}
+
+// Rounded upper half of the 128 bit product, from 32 bit halves
+static Owl_DiyFp owl_diyfp_multiply(const Owl_DiyFp x, const Owl_DiyFp y) {
+    const uint64_t mask = 0xffffffffu;
+    const uint64_t a = x.f >> 32, b = x.f & mask;
+    const uint64_t c = y.f >> 32, d = y.f & mask;
+    const uint64_t ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+    const uint64_t middle = (bd >> 32) + (ad & mask) + (bc & mask) + ((uint64_t)1 << 31);
+    return (Owl_DiyFp){.f = ac + (ad >> 32) + (bc >> 32) + (middle >> 32), .e = x.e + y.e + 64};
+}
+
+// The neighbours halfway to the next representable doubles, sharing the
+// upper one's exponent
+static void owl_diyfp_boundaries(const Owl_DiyFp v, Owl_DiyFp *minus, Owl_DiyFp *plus) {
+    *plus = owl_diyfp_normalize((Owl_DiyFp){.f = (v.f << 1) + 1, .e = v.e - 1});
+    // The gap below a power of two is half the gap above it, except at the
+    // smallest normal where subnormals continue with the same spacing
+    *minus = (v.f == OWL_DIYFP_HIDDEN_BIT && v.e != -1074 ? (Owl_DiyFp){.f = (v.f << 2) - 1, .e = v.e - 2} : (Owl_DiyFp){.f = (v.f << 1) - 1, .e = v.e - 1});
+    minus->f <<= minus->e - plus->e;
+    minus->e = plus->e;
+}
+
+// Picks the cached power that brings the product's exponent into
+// [-60, -32], returns it and its decimal exponent negated in k
+static Owl_DiyFp owl_cached_power(const int e, int *k) {
+    const double dk = (-61 - e) * 0.30102999566398114 + 347;
+    int estimate = (int)dk;
+    if (dk - estimate > 0.0) {
+        estimate++;
+    }
+    const unsigned index = (unsigned)((estimate >> 3) + 1);
+    *k = -(-348 + (int)index * 8);
+    return owl_cached_powers[index];
+}
+
+// Moves the last digit down while that gets closer to the exact value
+// and stays inside the interval. distance is from the top of the unsafe
+// interval to the value and every quantity may be off by unit. Fails when
+// that error could change the digit chosen or put it outside the interval.
+static int owl_grisu_round(char *digits, const int length, const uint64_t distance, const uint64_t unsafe, uint64_t rest, const uint64_t ten_kappa, const uint64_t unit) {
+    const uint64_t small = distance - unit;
+    const uint64_t big = distance + unit;
+    while (rest < small && unsafe - rest >= ten_kappa && (rest + ten_kappa < small || small - rest >= rest + ten_kappa - small)) {
+        digits[length - 1]--;
+        rest += ten_kappa;
+    }
+    if (rest < big && unsafe - rest >= ten_kappa && (rest + ten_kappa < big || big - rest > rest + ten_kappa - big)) {
+        return 0;
+    }
+    return (2 * unit <= rest && rest <= unsafe - 4 * unit);
+}
+
+static int owl_count_digits(const uint32_t n) {
+    int count = 1;
+    for (uint32_t limit = 10; count < 10 && n >= limit; limit *= 10) {
+        count++;
+    }
+    return count;
+}
+
+// Returns the number of digits, or zero when the approximation can't
+// decide them
+static int owl_grisu_digits(const Owl_DiyFp low, const Owl_DiyFp w, const Owl_DiyFp high, char *digits, int *k) {
+    uint64_t unit = 1;
+    const uint64_t too_low = low.f - unit;
+    const uint64_t too_high = high.f + unit;
+    uint64_t unsafe = too_high - too_low;
+    const int shift = -w.e;
+    const uint64_t one = (uint64_t)1 << shift;
+    uint32_t integral = (uint32_t)(too_high >> shift);
+    uint64_t fraction = too_high & (one - 1);
+    int kappa = owl_count_digits(integral);
+    int length = 0;
+
+    while (kappa > 0) {
+        const uint64_t divisor = owl_pow10[kappa - 1];
+        digits[length++] = (char)('0' + integral / divisor);
+        integral %= divisor;
+        kappa--;
+        const uint64_t rest = ((uint64_t)integral << shift) + fraction;
+        if (rest < unsafe) {
+            *k += kappa;
+            return (owl_grisu_round(digits, length, too_high - w.f, unsafe, rest, divisor << shift, unit) ? length : 0);
+        }
+    }
+
+    for (;;) {
+        fraction *= 10;
+        unit *= 10;
+        unsafe *= 10;
+        digits[length++] = (char)('0' + (fraction >> shift));
+        fraction &= one - 1;
+        kappa--;
+        if (fraction < unsafe) {
+            *k += kappa;
+            return (owl_grisu_round(digits, length, (too_high - w.f) * unit, unsafe, fraction, one, unit) ? length : 0);
+        }
+    }
+}
+
+// Positive, finite and nonzero. Leaves the digits in digits and returns
+// their count, the value is digits * 10^k. Zero when Grisu3 gives up.
+static int owl_grisu3(const double value, char *digits, int *k) {
+    const Owl_DiyFp v = owl_diyfp_from(value);
+    Owl_DiyFp minus, plus;
+    owl_diyfp_boundaries(v, &minus, &plus);
+
+    const Owl_DiyFp power = owl_cached_power(plus.e, k);
+    const Owl_DiyFp w = owl_diyfp_multiply(owl_diyfp_normalize(v), power);
+    const Owl_DiyFp upper = owl_diyfp_multiply(plus, power);
+    const Owl_DiyFp lower = owl_diyfp_multiply(minus, power);
+    return owl_grisu_digits(lower, w, upper, digits, k);
+}
+
+// The shortest correctly rounded significand that reads back as the
+// value. Once some precision reads back every higher one does, so the
+// precision is found by bisection.
+static int owl_shortest_slow(const double value, char *digits, int *k) {
+    char text[OWL_NUMBER_BUFFER];
+    int low = 1;
+    int high = 17;
+    while (low < high) {
+        const int precision = (low + high) / 2;
+        snprintf(text, sizeof(text), "%.*e", precision - 1, value);
+        if (strtod(text, NULL) == value) {
+            high = precision;
+        } else {
+            low = precision + 1;
+        }
+    }
+    snprintf(text, sizeof(text), "%.*e", low - 1, value);
+
+    // d.ddde+x
+    int length = 0;
+    const char *c = text;
+    for (; *c != 'e'; c++) {
+        if (*c != '.') {
+            digits[length++] = *c;
+        }
+    }
+    *k = atoi(c + 1) - (length - 1);
+    return length;
+}
+
+static char *owl_write_exponent(char *out, int exponent) {
+    *out++ = 'e';
+    *out++ = (exponent < 0 ? '-' : '+');
+    if (exponent < 0) {
+        exponent = -exponent;
+    }
+    if (exponent >= 100) {
+        *out++ = (char)('0' + exponent / 100);
+        exponent %= 100;
+        *out++ = (char)('0' + exponent / 10);
+    } else if (exponent >= 10) {
+        *out++ = (char)('0' + exponent / 10);
+    }
+    *out++ = (char)('0' + exponent % 10);
+    return out;
+}
+
+size_t owl_number_format(const double value, char *out) {
+    char *start = out;
+    if (isnan(value)) {
+        memcpy(out, "nan", 4);
+        return 3;
+    }
+    if (signbit(value)) {
+        *out++ = '-';
+    }
+    if (isinf(value)) {
+        memcpy(out, "inf", 4);
+        return (size_t)(out - start) + 3;
+    }
+    if (value == 0.0) {
+        memcpy(out, "0", 2);
+        return (size_t)(out - start) + 1;
+    }
+
+    char digits[OWL_NUMBER_BUFFER];
+    int k = 0;
+    const double magnitude = (value < 0.0 ? -value : value);
+    int length = owl_grisu3(magnitude, digits, &k);
+    if (length == 0) {
+        length = owl_shortest_slow(magnitude, digits, &k);
+    }
+    // The decimal point goes after this many digits
+    const int point = length + k;
+
+    if (length <= point && point <= OWL_NUMBER_MAX_FIXED) {
+        // 1234e3 -> 1234000
+        memcpy(out, digits, (size_t)length);
+        memset(out + length, '0', (size_t)(point - length));
+        out += point;
+    } else if (0 < point && point <= OWL_NUMBER_MAX_FIXED) {
+        // 1234e-2 -> 12.34
+        memcpy(out, digits, (size_t)point);
+        out[point] = '.';
+        memcpy(out + point + 1, digits + point, (size_t)(length - point));
+        out += length + 1;
+    } else if (OWL_NUMBER_MIN_FIXED < point && point <= 0) {
+        // 1234e-6 -> 0.001234
+        out[0] = '0';
+        out[1] = '.';
+        memset(out + 2, '0', (size_t)-point);
+        memcpy(out + 2 - point, digits, (size_t)length);
+        out += 2 - point + length;
+    } else {
+        // 1234e30 -> 1.234e+33
+        *out++ = digits[0];
+        if (length > 1) {
+            *out++ = '.';
+            memcpy(out, digits + 1, (size_t)(length - 1));
+            out += length - 1;
+        }
+        out = owl_write_exponent(out, point - 1);
+    }
+    *out = '\0';
+    return (size_t)(out - start);
+}
+
+// Powers of ten that are exact as doubles
+static const double owl_exact_pow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+// Clinger's fast path: with an exact significand and an exact power of
+// ten, a single correctly rounded operation gives the right answer
+static int owl_number_fast(const uint64_t significand, const int exponent, double *value) {
+    const uint64_t exact = (uint64_t)1 << 53;
+    if (significand > exact || exponent < -22 || exponent > 22 + 15) {
+        return 0;
+    }
+    if (exponent < 0) {
+        *value = (double)significand / owl_exact_pow10[-exponent];
+    } else if (exponent <= 22) {
+        *value = (double)significand * owl_exact_pow10[exponent];
+    } else {
+        // Move the excess into the significand while that stays exact
+        const uint64_t scale = owl_pow10[exponent - 22];
+        if (significand > exact / scale) {
+            return 0;
+        }
+        *value = (double)(significand * scale) * owl_exact_pow10[22];
+    }
+    return 1;
+}
+
+// Everything else goes to strtod. It reads the decimal point from the
+// locale, which owl leaves at "C".
+static double owl_number_parse_slow(const char *data, const size_t length) {
+    char local[OWL_NUMBER_PARSE_BUFFER];
+    char *text = (length < sizeof(local) ? local : malloc(length + 1));
+    if (text == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+    memcpy(text, data, length);
+    text[length] = '\0';
+    const double value = strtod(text, NULL);
+    if (text != local) {
+        free(text);
+    }
+    return value;
+}
+
+static int owl_is_digit(const char c) {
+    return (c >= '0' && c <= '9');
+}
+
+static size_t owl_number_parse_word(const char *data, const size_t length, const char *word, const size_t word_length) {
+    if (length < word_length) return 0;
+    for (size_t i = 0; i < word_length; i++) {
+        if ((data[i] | 0x20) != word[i]) return 0;
+    }
+    return word_length;
+}
+
+size_t owl_number_parse(const char *data, const size_t length, double *out) {
+    size_t i = 0;
+    const int negative = (length > 0 && data[0] == '-');
+    if (length > 0 && (data[0] == '-' || data[0] == '+')) {
+        i++;
+    }
+
+    const size_t special = (owl_number_parse_word(data + i, length - i, "inf", 3) + owl_number_parse_word(data + i, length - i, "nan", 3));
+    if (special != 0) {
+        *out = (data[i] == 'n' || data[i] == 'N' ? NAN : INFINITY);
+        *out = (negative ? -*out : *out);
+        return i + special;
+    }
+
+    // Up to 19 significant digits fit in the significand, the exponent
+    // absorbs the rest
+    uint64_t significand = 0;
+    int significant = 0;
+    int exponent = 0;
+    int inexact = 0;
+    size_t digits = 0;
+    for (; i < length && owl_is_digit(data[i]); i++, digits++) {
+        if (significant < 19) {
+            significand = significand * 10 + (uint64_t)(data[i] - '0');
+            significant += (significand != 0);
+        } else {
+            exponent++;
+            inexact |= (data[i] != '0');
+        }
+    }
+    if (i < length && data[i] == '.') {
+        i++;
+        for (; i < length && owl_is_digit(data[i]); i++, digits++) {
+            if (significant < 19) {
+                significand = significand * 10 + (uint64_t)(data[i] - '0');
+                significant += (significand != 0);
+                exponent--;
+            } else {
+                inexact |= (data[i] != '0');
+            }
+        }
+    }
+    if (digits == 0) {
+        return 0;
+    }
+    if (i < length && (data[i] == 'e' || data[i] == 'E')) {
+        size_t j = i + 1;
+        int exponent_negative = 0;
+        if (j < length && (data[j] == '-' || data[j] == '+')) {
+            exponent_negative = (data[j] == '-');
+            j++;
+        }
+        if (j < length && owl_is_digit(data[j])) {
+            int explicit = 0;
+            for (; j < length && owl_is_digit(data[j]); j++) {
+                if (explicit < 100000) {
+                    explicit = explicit * 10 + (data[j] - '0');
+                }
+            }
+            exponent += (exponent_negative ? -explicit : explicit);
+            i = j;
+        }
+    }
+
+    double value = 0.0;
+    if (significand != 0 && (inexact || owl_number_fast(significand, exponent, &value) == 0)) {
+        *out = owl_number_parse_slow(data, i);
+        return i;
+    }
+    *out = (negative ? -value : value);
+    return i;
+}
@@ -0,0 +1,34 @@
+#ifndef OWL_NUMBERS_H
+#define OWL_NUMBERS_H
+#include <stddef.h>
+#include <stdint.h>
+
+// Room for any formatted double and its terminator
+#define OWL_NUMBER_BUFFER \
+    32
+
+// Decimal exponents, as a count of digits before the point, that are
+// written out in full. Outside (MIN, MAX] numbers switch to 1.5e+30 form.
+#define OWL_NUMBER_MAX_FIXED \
+    21
+
+#define OWL_NUMBER_MIN_FIXED \
+    (-6)
+
+// Literals this long or longer that miss the fast path are copied to the
+// heap to be terminated for strtod
+#define OWL_NUMBER_PARSE_BUFFER \
+    128
+
+// Writes the shortest text that parses back to exactly this value, as 1,
+// 0.25, 1e+21, -inf or nan. Among equally short candidates it picks the
+// closest. Returns its length, out needs room for OWL_NUMBER_BUFFER bytes
+// and is terminated.
+size_t owl_number_format(double value, char *out);
+
+// Parses a decimal literal with an optional sign, fraction and exponent,
+// or inf or nan, from the start of data. Returns how many bytes it took,
+// zero if there is no number there.
+size_t owl_number_parse(const char *data, size_t length, double *out);
+
+#endif //OWL_NUMBERS_H
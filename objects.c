@@ -1,136 +1,211 @@
 #include "objects.h"
+#include "numbers.h"
+#include "rope.h"
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
-static void owl_object_tostring_impl(Owl_String *out, const Owl_Object *object, Owl_Alloc alloc);
+// Big enough that tostring rarely hands the string more than one piece
+#define OWL_TOSTRING_BUFFER \
+    256
 
-Owl_Boolean owl_check_symbol(const Owl_Object *object, const char *sym) {
-    return (object->type == OWL_SYMBOL ? strcmp(object->symbol.data, sym) == 0 : F);
+Owl_Boolean owl_check_symbol(const Owl_Object *object, const Owl_Object *symbol) {
+    return (object == symbol ? T : F);
 }
 
-static void owl_object_tostring_list(Owl_String *out, const Owl_Object *list, Owl_Alloc alloc) {
-    owl_string_append_cstr(out, "(", alloc);
+static void owl_write_number(Owl_Writer *writer, const double number) {
+    char buffer[OWL_NUMBER_BUFFER];
+    owl_writer_write(writer, buffer, owl_number_format(number, buffer));
+}
+
+static void owl_object_write_list(Owl_Writer *writer, const Owl_Object *list) {
+    owl_writer_write_cstr(writer, "(");
     const Owl_Object *node = list;
     Owl_Boolean first = T;
     while (node != NULL) {
         if (node->value != NULL) {
             if (!first) {
-                owl_string_append_cstr(out, " ", alloc);
+                owl_writer_write_cstr(writer, " ");
             }
-            owl_object_tostring_impl(out, node->value, alloc);
+            owl_object_write(writer, node->value);
             first = F;
         }
         node = node->next;
     }
-    owl_string_append_cstr(out, ")", alloc);
+    owl_writer_write_cstr(writer, ")");
 }
 
-static void owl_object_tostring_array(Owl_String *out, const Owl_Object *array, Owl_Alloc alloc) {
-    owl_string_append_cstr(out, "[", alloc);
+static void owl_object_write_array(Owl_Writer *writer, const Owl_Object *array) {
+    owl_writer_write_cstr(writer, "[");
     for (size_t i = 0; i < array->length; i++) {
         if (i > 0) {
-            owl_string_append_cstr(out, " ", alloc);
+            owl_writer_write_cstr(writer, " ");
         }
         if (array->array[i] != NULL) {
-            owl_object_tostring_impl(out, array->array[i], alloc);
+            owl_object_write(writer, array->array[i]);
         } else {
-            owl_string_append_cstr(out, "()", alloc);
+            owl_writer_write_cstr(writer, "()");
         }
     }
-    owl_string_append_cstr(out, "]", alloc);
+    owl_writer_write_cstr(writer, "]");
 }
 
-static void owl_object_tostring_dict(Owl_String *out, const Owl_Object *dict, Owl_Alloc alloc) {
-    owl_string_append_cstr(out, "{", alloc);
-    const Owl_Object *node = dict;
+static void owl_object_write_f64_array(Owl_Writer *writer, const Owl_Object *array) {
+    owl_writer_write_cstr(writer, "#f64[");
+    for (size_t i = 0; i < array->f64_length; i++) {
+        if (i > 0) {
+            owl_writer_write_cstr(writer, " ");
+        }
+        owl_write_number(writer, array->f64[i]);
+    }
+    owl_writer_write_cstr(writer, "]");
+}
+
+static void owl_object_write_dict(Owl_Writer *writer, const Owl_Object *dict) {
+    owl_writer_write_cstr(writer, "{");
     Owl_Boolean first = T;
-    while (node != NULL) {
+    for (size_t i = 0; i < dict->dict_capacity; i++) {
+        const Owl_DictSlot *slot = &dict->dict_slots[i];
+        if (slot->distance == 0) continue;
         if (!first) {
-            owl_string_append_cstr(out, ", ", alloc);
-        }
-        if (node->dict_key) {
-            owl_object_tostring_impl(out, node->dict_key, alloc);
-        } else {
-            owl_string_append_cstr(out, "()", alloc);
-        }
-        owl_string_append_cstr(out, " = ", alloc);
-        if (node->dict_value) {
-            owl_object_tostring_impl(out, node->dict_value, alloc);
-        } else {
-            owl_string_append_cstr(out, "()", alloc);
+            owl_writer_write_cstr(writer, ", ");
         }
+        owl_object_write(writer, slot->key);
+        owl_writer_write_cstr(writer, " = ");
+        owl_object_write(writer, slot->value);
         first = F;
-        node = node->dict_next;
     }
-    owl_string_append_cstr(out, "}", alloc);
+    owl_writer_write_cstr(writer, "}");
 }
 
-static void owl_object_tostring_impl(Owl_String *out, const Owl_Object *object, Owl_Alloc alloc) {
+void owl_object_write(Owl_Writer *writer, const Owl_Object *object) {
     if (object == NULL) {
-        owl_string_append_cstr(out, "()", alloc);
+        owl_writer_write_cstr(writer, "()");
         return;
     }
 
-    char buffer[64];
-    switch (object->type) {
+    switch (OWL_TYPE(object)) {
         case OWL_NOTHING:
-            owl_string_append_cstr(out, "()", alloc);
+            owl_writer_write_cstr(writer, "()");
             break;
         case OWL_NUMBER:
-            snprintf(buffer, sizeof(buffer), "%g", object->number);
-            owl_string_append_cstr(out, buffer, alloc);
+            owl_write_number(writer, object->number);
             break;
         case OWL_BOOLEAN:
-            owl_string_append_cstr(out, object->boolean == T ? "#t" : "#f", alloc);
+            owl_writer_write_cstr(writer, object->boolean == T ? "#t" : "#f");
             break;
         case OWL_SYMBOL:
-            owl_string_append(out, object->symbol, alloc);
+            owl_writer_write(writer, object->symbol.data, object->symbol.length);
             break;
         case OWL_STRING:
-            owl_string_append_cstr(out, "\"", alloc);
-            owl_string_append(out, object->string, alloc);
-            owl_string_append_cstr(out, "\"", alloc);
+            owl_writer_write_cstr(writer, "\"");
+            owl_writer_write_string(writer, object->string);
+            owl_writer_write_cstr(writer, "\"");
+            break;
+        case OWL_ROPE:
+            owl_writer_write_cstr(writer, "\"");
+            owl_rope_write(writer, object);
+            owl_writer_write_cstr(writer, "\"");
             break;
         case OWL_LIST:
-            owl_object_tostring_list(out, object, alloc);
+            owl_object_write_list(writer, object);
             break;
         case OWL_ARRAY:
-            owl_object_tostring_array(out, object, alloc);
+            owl_object_write_array(writer, object);
             break;
         case OWL_DICT:
-            owl_object_tostring_dict(out, object, alloc);
+            owl_object_write_dict(writer, object);
+            break;
+        case OWL_F64_ARRAY:
+            owl_object_write_f64_array(writer, object);
             break;
     }
 }
 
+void owl_value_write(Owl_Writer *writer, const Owl_Value value) {
+    if (OWL_VALUE_IS_OBJECT(value)) {
+        owl_object_write(writer, OWL_VALUE_AS_OBJECT(value));
+    } else if (OWL_VALUE_IS_NUMBER(value)) {
+        owl_write_number(writer, owl_value_as_number(value));
+    } else if (OWL_VALUE_IS_BOOLEAN(value)) {
+        owl_writer_write_cstr(writer, OWL_VALUE_AS_BOOLEAN(value) ? "#t" : "#f");
+    } else {
+        owl_writer_write_cstr(writer, "()");
+    }
+}
+
 Owl_String owl_object_tostring(const Owl_Object *object, Owl_Alloc alloc) {
-    Owl_String out = owl_string_new(alloc);
-    owl_object_tostring_impl(&out, object, alloc);
-    return out;
+    return owl_value_tostring(owl_value_from_object(object), alloc);
 }
 
-void owl_stack_push(Owl_Stack *stack, Owl_Object *object, Owl_Alloc alloc) {
+Owl_String owl_value_tostring(const Owl_Value value, Owl_Alloc alloc) {
+    char buffer[OWL_TOSTRING_BUFFER];
+    Owl_StringSink target = {.string = owl_string_new(alloc), .alloc = alloc};
+    Owl_Writer writer = owl_writer_init(owl_string_sink(&target), buffer, sizeof(buffer), alloc);
+    owl_value_write(&writer, value);
+    owl_writer_flush(&writer);
+    return target.string;
+}
+
+void owl_stack_push(Owl_Stack *stack, const Owl_Value value, Owl_Alloc alloc) {
     if (stack->capacity == 0) {
         stack->capacity = 16;
         stack->length = 0;
         stack->data =
-            OWL_NEW(alloc, sizeof(Owl_Object) * stack->capacity);
+            OWL_NEW(alloc, sizeof(Owl_Value) * stack->capacity);
     }
     if (stack->length >= stack->capacity) {
         stack->capacity *= 2;
-        size_t new_size = sizeof(Owl_Object) * stack->capacity;
-        Owl_Object **new_data =
+        size_t new_size = sizeof(Owl_Value) * stack->capacity;
+        Owl_Value *new_data =
             OWL_NEW(alloc, new_size);
-        memcpy(new_data, stack->data, stack->length * sizeof(Owl_Object));
+        memcpy(new_data, stack->data, stack->length * sizeof(Owl_Value));
         OWL_DEL(alloc, stack->data);
         stack->data = new_data;
     }
-    stack->data[stack->length++] = object;
+    stack->data[stack->length++] = value;
+}
+
+void owl_stack_reserve(Owl_Stack *stack, const size_t extra, Owl_Alloc alloc) {
+    if (stack->length + extra <= stack->capacity) {
+        return;
+    }
+    size_t capacity = (stack->capacity == 0 ? 16 : stack->capacity);
+    while (capacity < stack->length + extra) {
+        capacity *= 2;
+    }
+    Owl_Value *data = OWL_NEW(alloc, sizeof(Owl_Value) * capacity);
+    if (data == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+    if (stack->data != NULL) {
+        memcpy(data, stack->data, stack->length * sizeof(Owl_Value));
+        OWL_DEL(alloc, stack->data);
+    }
+    stack->data = data;
+    stack->capacity = capacity;
 }
 
-Owl_Object *owl_stack_pop(Owl_Stack *stack) {
+Owl_Value owl_stack_pop(Owl_Stack *stack) {
     if (stack->length <= 0)
-        return NULL;
+        return OWL_VALUE_NOTHING;
     return stack->data[--stack->length];
 }
+
+Owl_Value owl_value_from_object(const Owl_Object *object) {
+    if (object == NULL) {
+        return OWL_VALUE_NOTHING;
+    }
+    switch (OWL_TYPE(object)) {
+        case OWL_NOTHING:
+            return OWL_VALUE_NOTHING;
+        case OWL_NUMBER:
+            return owl_value_number(object->number);
+        case OWL_BOOLEAN:
+            return OWL_VALUE_BOOLEAN(object->boolean == T);
+        default:
+            return OWL_VALUE_OBJECT(object);
+    }
+}
@@ -5,6 +5,8 @@
 
 #include "alloc.h"
 #include "strings.h"
+#include "value.h"
+#include "writer.h"
 
 enum Owl_Boolean {
     F = 0,
@@ -21,18 +23,59 @@ enum Owl_ObjectType {
     OWL_STRING,
     OWL_LIST,
     OWL_ARRAY,
-    OWL_DICT
+    OWL_DICT,
+    // Unboxed doubles stored contiguously
+    OWL_F64_ARRAY,
+    // A string concatenated out of two others, it turns into an OWL_STRING
+    // in place once its contents are needed
+    OWL_ROPE
 };
 
 typedef enum Owl_ObjectType Owl_ObjectType;
 
-// TODO: optimize size
+// Symbols are interned by the GC, so two symbols are equal exactly when
+// they are the same object. Short names are kept in bytes, which is
+// safe to point data at because symbols are pinned.
+struct Owl_Symbol {
+    char *data;
+    size_t length;
+    uint32_t hash;
+    uint32_t id;
+    char bytes[OWL_STRING_SMALL + 1];
+};
+
+typedef struct Owl_Symbol Owl_Symbol;
+
+// Every object is preceded by a packed header word, the low byte holds
+// the type and the bits above it belong to the collector (see gc.h)
+#define OWL_OBJECT_HEADER_WORD(o) \
+    (((const uint64_t *)(const void *)(o))[-1])
+
+#define OWL_OBJECT_TYPE_MASK \
+    ((uint64_t)0xff)
+
+#define OWL_TYPE(o) \
+    ((Owl_ObjectType)(OWL_OBJECT_HEADER_WORD(o) & OWL_OBJECT_TYPE_MASK))
+
+struct Owl_Object;
+
+// A dict slot is empty when distance is zero, otherwise it holds how far
+// the entry sits from its home slot plus one
+struct Owl_DictSlot {
+    struct Owl_Object *key;
+    struct Owl_Object *value;
+    uint32_t hash;
+    uint32_t distance;
+};
+
+typedef struct Owl_DictSlot Owl_DictSlot;
+
+// Objects are only allocated as large as the member their type uses
 struct Owl_Object {
-    Owl_ObjectType type;
     union {
         double number;
         Owl_String string;
-        Owl_String symbol;
+        Owl_Symbol symbol;
         Owl_Boolean boolean;
         struct {
             struct Owl_Object *value;
@@ -43,10 +86,22 @@ struct Owl_Object {
             size_t length;
             size_t capacity;
         };
+        // Open addressed with Robin Hood probing, the capacity is zero or
+        // a power of two
+        struct {
+            Owl_DictSlot *dict_slots;
+            size_t dict_length;
+            size_t dict_capacity;
+        };
+        struct {
+            double *f64;
+            size_t f64_length;
+        };
+        // Laid over a string of the same size so it can be flattened in place
         struct {
-            struct Owl_Object *dict_key;
-            struct Owl_Object *dict_value;
-            struct Owl_Object *dict_next;
+            struct Owl_Object *rope_left;
+            struct Owl_Object *rope_right;
+            size_t rope_length;
         };
     };
 };
@@ -54,22 +109,36 @@ struct Owl_Object {
 typedef struct Owl_Object Owl_Object;
 
 struct Owl_Stack {
-    Owl_Object **data;
+    Owl_Value *data;
     size_t length;
     size_t capacity;
 };
 
 typedef struct Owl_Stack Owl_Stack;
-void owl_stack_push(Owl_Stack *stack, Owl_Object *object, Owl_Alloc alloc);
-Owl_Object *owl_stack_pop(Owl_Stack *stack);
+void owl_stack_push(Owl_Stack *stack, Owl_Value value, Owl_Alloc alloc);
+// Makes room for extra more values without moving them again
+void owl_stack_reserve(Owl_Stack *stack, size_t extra, Owl_Alloc alloc);
+// Popping an empty stack gives nothing
+Owl_Value owl_stack_pop(Owl_Stack *stack);
 
-Owl_Boolean owl_check_symbol(const Owl_Object *object, const char *sym);
+// Numbers, booleans and nothing are unboxed, other objects are referenced
+Owl_Value owl_value_from_object(const Owl_Object *object);
+
+Owl_Boolean owl_check_symbol(const Owl_Object *object, const Owl_Object *symbol);
 
 #define OWL_EACH(ident, list) \
     for (Owl_Object *(ident) = (list); (ident) != NULL; (ident) = (ident)->next)
 
 Owl_String owl_string_new(Owl_Alloc alloc);
 
+// Serializes straight to the writer, nothing is built in memory besides
+// the writer's own buffer
+void owl_object_write(Owl_Writer *writer, const Owl_Object *object);
+
+void owl_value_write(Owl_Writer *writer, Owl_Value value);
+
 Owl_String owl_object_tostring(const Owl_Object *object, Owl_Alloc alloc);
 
+Owl_String owl_value_tostring(Owl_Value value, Owl_Alloc alloc);
+
 #endif //OWL_OBJECTS_H
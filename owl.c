@@ -4,7 +4,8 @@
 #include "gc.h"
 
 int main(const int argc, const char **argv) {
-    Owl_Alloc alloc = owl_default_alloc_init();
+    Owl_Slab slab = owl_slab_init();
+    Owl_Alloc alloc = owl_slab_alloc(&slab);
     Owl_GC gc = owl_gc_init(alloc);
 
     Owl_Object *script = owl_new_list(&gc);
@@ -22,10 +23,8 @@ int main(const int argc, const char **argv) {
 
     owl_eval(&gc, script);
 
-    owl_gc_mark(&gc);
-    owl_gc_sweep(&gc);
-
     owl_gc_deinit(&gc);
+    owl_slab_deinit(&slab);
 
     return 0;
 }
@@ -0,0 +1,128 @@
+#include "rope.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+size_t owl_rope_length(const Owl_Object *object) {
+    return (OWL_TYPE(object) == OWL_ROPE ? object->rope_length : object->string.length);
+}
+
+// Pending nodes of a traversal, on the C stack until there are too many
+struct Owl_RopeStack {
+    const Owl_Object **data;
+    size_t length;
+    size_t capacity;
+    Owl_Alloc alloc;
+    const Owl_Object *local[OWL_ROPE_STACK];
+};
+
+typedef struct Owl_RopeStack Owl_RopeStack;
+
+static void owl_rope_stack_push(Owl_RopeStack *stack, const Owl_Object *node) {
+    if (stack->length == stack->capacity) {
+        const Owl_Object **grown = OWL_NEW(stack->alloc, sizeof(Owl_Object *) * stack->capacity * 2);
+        if (grown == NULL) {
+            fprintf(stderr, "Out of memory\n");
+            exit(1);
+        }
+        memcpy(grown, stack->data, sizeof(Owl_Object *) * stack->length);
+        if (stack->data != stack->local) {
+            OWL_DEL(stack->alloc, stack->data);
+        }
+        stack->data = grown;
+        stack->capacity *= 2;
+    }
+    stack->data[stack->length++] = node;
+}
+
+static void owl_rope_stack_free(Owl_RopeStack *stack) {
+    if (stack->data != stack->local) {
+        OWL_DEL(stack->alloc, stack->data);
+    }
+}
+
+void owl_rope_copy(const Owl_Object *object, char *out, Owl_Alloc alloc) {
+    Owl_RopeStack stack = {.length = 0, .capacity = OWL_ROPE_STACK, .alloc = alloc};
+    stack.data = stack.local;
+    char *end = out + owl_rope_length(object);
+
+    // Leaves are written back to front, taking the right side first keeps
+    // the stack short for the left leaning ropes appends produce
+    owl_rope_stack_push(&stack, object);
+    while (stack.length > 0) {
+        const Owl_Object *node = stack.data[--stack.length];
+        if (OWL_TYPE(node) != OWL_ROPE) {
+            end -= node->string.length;
+            memcpy(end, owl_string_data(&node->string), node->string.length);
+            continue;
+        }
+        owl_rope_stack_push(&stack, node->rope_left);
+        owl_rope_stack_push(&stack, node->rope_right);
+    }
+    owl_rope_stack_free(&stack);
+}
+
+void owl_rope_write(Owl_Writer *writer, const Owl_Object *object) {
+    Owl_RopeStack stack = {.length = 0, .capacity = OWL_ROPE_STACK, .alloc = writer->alloc};
+    stack.data = stack.local;
+
+    // In order this time, so the stack holds a right side per level
+    owl_rope_stack_push(&stack, object);
+    while (stack.length > 0) {
+        const Owl_Object *node = stack.data[--stack.length];
+        if (OWL_TYPE(node) != OWL_ROPE) {
+            owl_writer_write_string(writer, node->string);
+            continue;
+        }
+        owl_rope_stack_push(&stack, node->rope_right);
+        owl_rope_stack_push(&stack, node->rope_left);
+    }
+    owl_rope_stack_free(&stack);
+}
+
+Owl_Object *owl_rope_concat(Owl_GC *gc, Owl_Object *lhs, Owl_Object *rhs) {
+    const size_t lhs_length = owl_rope_length(lhs);
+    const size_t rhs_length = owl_rope_length(rhs);
+    if (lhs_length == 0) return rhs;
+    if (rhs_length == 0) return lhs;
+
+    const size_t length = lhs_length + rhs_length;
+    if (length <= OWL_STRING_SMALL) {
+        Owl_Object *string = owl_gc_new(gc, OWL_STRING);
+        string->string = owl_string_new(gc->alloc);
+        owl_rope_copy(lhs, string->string.bytes, gc->alloc);
+        owl_rope_copy(rhs, string->string.bytes + lhs_length, gc->alloc);
+        string->string.bytes[length] = '\0';
+        string->string.length = length;
+        return string;
+    }
+
+    // The node is young, so it needs no write barrier
+    Owl_Object *rope = owl_gc_new(gc, OWL_ROPE);
+    rope->rope_left = lhs;
+    rope->rope_right = rhs;
+    rope->rope_length = length;
+    return rope;
+}
+
+Owl_Object *owl_rope_flatten(Owl_GC *gc, Owl_Object *object) {
+    if (OWL_TYPE(object) != OWL_ROPE) return object;
+
+    const size_t length = object->rope_length;
+    Owl_String string = owl_string_new(gc->alloc);
+    owl_string_reserve(&string, length, gc->alloc);
+    if (length > OWL_STRING_SMALL && string.small) {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+    char *data = owl_string_data(&string);
+    owl_rope_copy(object, data, gc->alloc);
+    data[length] = '\0';
+    string.length = length;
+
+    // Dropping the children needs no barrier, only stores are tracked
+    object->string = string;
+    __atomic_fetch_xor(&OWL_GC_GET_HEADER(object)->word, (uint64_t)(OWL_ROPE ^ OWL_STRING), __ATOMIC_RELAXED);
+    return object;
+}
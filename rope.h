@@ -0,0 +1,27 @@
+#ifndef OWL_ROPE_H
+#define OWL_ROPE_H
+
+#include "gc.h"
+
+// Traversals keep this many pending nodes on the C stack before moving
+// the rest to the heap
+#define OWL_ROPE_STACK \
+    32
+
+// Concatenates two strings or ropes without copying either. Results short
+// enough to be stored inline come back as a flat string instead.
+Owl_Object *owl_rope_concat(Owl_GC *gc, Owl_Object *lhs, Owl_Object *rhs);
+
+// Turns a rope into a flat OWL_STRING in place and returns it, anything
+// else is returned as it is. Parts shared with other ropes are left alone.
+Owl_Object *owl_rope_flatten(Owl_GC *gc, Owl_Object *object);
+
+size_t owl_rope_length(const Owl_Object *object);
+
+// Writes the owl_rope_length bytes of a string or rope to out
+void owl_rope_copy(const Owl_Object *object, char *out, Owl_Alloc alloc);
+
+// Same for a writer, the pieces go out as they are found
+void owl_rope_write(Owl_Writer *writer, const Owl_Object *object);
+
+#endif //OWL_ROPE_H
@@ -6,37 +6,52 @@ static size_t owl_string_cstr_length(const char *text) {
     return (text == NULL ? 0 : strlen(text));
 }
 
-static char *owl_string_build_buffer(const char *lhs, size_t lhs_len, const char *rhs, size_t rhs_len, Owl_Alloc alloc) {
-    size_t total = lhs_len + rhs_len;
-    char *buffer = OWL_NEW(alloc, total + 1);
+// Copies the contents and then the suffix into a new heap buffer with
+// room for capacity bytes. The old storage is released last, so the
+// suffix may point into it.
+static void owl_string_regrow(Owl_String *string, size_t capacity, const char *suffix, size_t suffix_len, Owl_Alloc alloc) {
+    char *buffer = OWL_NEW(alloc, capacity + 1);
     if (!buffer) {
-        return NULL;
+        return;
+    }
+
+    const char *data = owl_string_data(string);
+    if (data && string->length > 0) {
+        memcpy(buffer, data, string->length);
     }
 
-    if (lhs && lhs_len > 0) {
-        memcpy(buffer, lhs, lhs_len);
+    if (suffix && suffix_len > 0) {
+        memcpy(buffer + string->length, suffix, suffix_len);
     }
 
-    if (rhs && rhs_len > 0) {
-        memcpy(buffer + lhs_len, rhs, rhs_len);
+    buffer[string->length + suffix_len] = '\0';
+
+    if (string->owned && !string->small && string->data) {
+        OWL_DEL(alloc, string->data);
     }
 
-    buffer[total] = '\0';
-    return buffer;
+    string->data = buffer;
+    string->length += suffix_len;
+    string->capacity = capacity;
+    string->owned = 1;
+    string->small = 0;
 }
 
-static void owl_string_replace_data(Owl_String *string, char *buffer, size_t length, Owl_Alloc alloc) {
-    if (!buffer) {
-        return;
+// Moves the contents of an owned or borrowed string inline, they must fit
+static void owl_string_inline(Owl_String *string, Owl_Alloc alloc) {
+    char bytes[OWL_STRING_SMALL + 1];
+    if (string->length > 0) {
+        memcpy(bytes, owl_string_data(string), string->length);
     }
+    bytes[string->length] = '\0';
 
-    if (string->owned && string->data) {
+    if (string->owned && !string->small && string->data) {
         OWL_DEL(alloc, string->data);
     }
 
-    string->data = buffer;
-    string->length = length;
+    memcpy(string->bytes, bytes, sizeof(bytes));
     string->owned = 1;
+    string->small = 1;
 }
 
 static void owl_string_append_bytes(Owl_String *string, const char *suffix, size_t suffix_len, Owl_Alloc alloc) {
@@ -44,58 +59,66 @@ static void owl_string_append_bytes(Owl_String *string, const char *suffix, size
         return;
     }
 
-    char *buffer = owl_string_build_buffer(string->data, string->length, suffix, suffix_len, alloc);
-    if (!buffer) {
+    size_t needed = string->length + suffix_len;
+    if (!string->owned && needed <= OWL_STRING_SMALL) {
+        owl_string_inline(string, alloc);
+    }
+
+    const size_t capacity = (string->small ? OWL_STRING_SMALL : string->capacity);
+    if (string->owned && needed <= capacity) {
+        char *data = owl_string_data(string);
+        memmove(data + string->length, suffix, suffix_len);
+        string->length = needed;
+        data[needed] = '\0';
         return;
     }
 
-    owl_string_replace_data(string, buffer, string->length + suffix_len, alloc);
+    size_t grown = (capacity < OWL_STRING_CAPACITY ? OWL_STRING_CAPACITY : capacity * 2);
+    while (grown < needed) {
+        grown *= 2;
+    }
+    owl_string_regrow(string, grown, suffix, suffix_len, alloc);
 }
 
 Owl_String owl_string_new([[maybe_unused]] Owl_Alloc alloc) {
-    Owl_String string = {};
+    Owl_String string = {.owned = 1, .small = 1};
+    return string;
+}
+
+Owl_String owl_string_from(const char *data, const size_t length, Owl_Alloc alloc) {
+    Owl_String string = owl_string_new(alloc);
+    owl_string_reserve(&string, length, alloc);
+    owl_string_append_bytes(&string, data, length, alloc);
     return string;
 }
 
 void owl_string_del(Owl_String *string, Owl_Alloc alloc) {
-    if (string->owned && string->data) {
+    if (string->owned && !string->small && string->data) {
         OWL_DEL(alloc, string->data);
     }
 
-    string->data = NULL;
-    string->length = 0;
-    string->owned = 0;
+    *string = (Owl_String){0};
 }
 
 Owl_String owl_string_concat(Owl_String lhs, Owl_String rhs, Owl_Alloc alloc) {
-    Owl_String result = {};
-    char *buffer = owl_string_build_buffer(lhs.data, lhs.length, rhs.data, rhs.length, alloc);
-    if (!buffer) {
-        return result;
-    }
-
-    result.data = buffer;
-    result.length = lhs.length + rhs.length;
-    result.owned = 1;
+    Owl_String result = owl_string_new(alloc);
+    owl_string_reserve(&result, lhs.length + rhs.length, alloc);
+    owl_string_append_bytes(&result, owl_string_data(&lhs), lhs.length, alloc);
+    owl_string_append_bytes(&result, owl_string_data(&rhs), rhs.length, alloc);
     return result;
 }
 
 Owl_String owl_string_concat_cstr(Owl_String lhs, const char *rhs, Owl_Alloc alloc) {
-    Owl_String result = {};
     size_t rhs_len = owl_string_cstr_length(rhs);
-    char *buffer = owl_string_build_buffer(lhs.data, lhs.length, rhs, rhs_len, alloc);
-    if (!buffer) {
-        return result;
-    }
-
-    result.data = buffer;
-    result.length = lhs.length + rhs_len;
-    result.owned = 1;
+    Owl_String result = owl_string_new(alloc);
+    owl_string_reserve(&result, lhs.length + rhs_len, alloc);
+    owl_string_append_bytes(&result, owl_string_data(&lhs), lhs.length, alloc);
+    owl_string_append_bytes(&result, rhs, rhs_len, alloc);
     return result;
 }
 
 void owl_string_append(Owl_String *string, Owl_String suffix, Owl_Alloc alloc) {
-    owl_string_append_bytes(string, suffix.data, suffix.length, alloc);
+    owl_string_append_bytes(string, owl_string_data(&suffix), suffix.length, alloc);
 }
 
 void owl_string_append_cstr(Owl_String *string, const char *suffix, Owl_Alloc alloc) {
@@ -112,3 +135,41 @@ void owl_string_add_line_cstr(Owl_String *string, const char *line, Owl_Alloc al
     owl_string_append_cstr(string, line, alloc);
     owl_string_append_cstr(string, "\n", alloc);
 }
+
+void owl_string_reserve(Owl_String *string, size_t capacity, Owl_Alloc alloc) {
+    if (capacity < string->length) {
+        capacity = string->length;
+    }
+    if (capacity <= OWL_STRING_SMALL) {
+        if (!string->owned) {
+            owl_string_inline(string, alloc);
+        }
+        return;
+    }
+    if (string->owned && !string->small && capacity <= string->capacity) {
+        return;
+    }
+    owl_string_regrow(string, capacity, NULL, 0, alloc);
+}
+
+void owl_string_shrink(Owl_String *string, Owl_Alloc alloc) {
+    if (!string->owned || string->small) {
+        return;
+    }
+    if (string->length <= OWL_STRING_SMALL) {
+        owl_string_inline(string, alloc);
+        return;
+    }
+    if (string->capacity > string->length) {
+        owl_string_regrow(string, string->length, NULL, 0, alloc);
+    }
+}
+
+uint32_t owl_string_hash(const char *data, const size_t length) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (unsigned char)data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
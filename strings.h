@@ -1,19 +1,48 @@
 #ifndef OWL_STRINGS_H
 #define OWL_STRINGS_H
 #include <stddef.h>
+#include <stdint.h>
 
 #include "alloc.h"
 
+// Owned strings up to this long are stored inline, with a terminator
+#define OWL_STRING_SMALL \
+    15
+
+// Capacity of the first buffer an append allocates once a string no
+// longer fits inline
+#define OWL_STRING_CAPACITY \
+    32
+
+// Owned strings are either small, held in bytes, or keep capacity bytes
+// plus a terminator on the heap and double it when they run out. A
+// borrowed string has capacity zero and is copied into storage of its own
+// the first time it's appended to. Read the contents through
+// owl_string_data, since small strings travel with the struct.
 struct Owl_String {
-    char *data;
+    union {
+        struct {
+            char *data;
+            size_t capacity;
+        };
+        char bytes[OWL_STRING_SMALL + 1];
+    };
     size_t length;
     int owned;
+    int small;
 };
 
 typedef struct Owl_String Owl_String;
 
+static inline char *owl_string_data(const Owl_String *string) {
+    return (string->small ? (char *)string->bytes : string->data);
+}
+
 Owl_String owl_string_new(Owl_Alloc alloc);
 
+// Owned copy of length bytes
+Owl_String owl_string_from(const char *data, size_t length, Owl_Alloc alloc);
+
 void owl_string_del(Owl_String *string, Owl_Alloc alloc);
 
 Owl_String owl_string_concat(Owl_String lhs, Owl_String rhs, Owl_Alloc alloc);
@@ -28,4 +57,13 @@ void owl_string_add_line(Owl_String *string, Owl_String line, Owl_Alloc alloc);
 
 void owl_string_add_line_cstr(Owl_String *string, const char *line, Owl_Alloc alloc);
 
+// Makes room for at least capacity bytes without further allocation
+void owl_string_reserve(Owl_String *string, size_t capacity, Owl_Alloc alloc);
+
+// Gives back whatever capacity the contents don't use
+void owl_string_shrink(Owl_String *string, Owl_Alloc alloc);
+
+// FNV-1a, shared by symbols and dict keys
+uint32_t owl_string_hash(const char *data, size_t length);
+
 #endif //OWL_STRINGS_H
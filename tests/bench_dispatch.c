@@ -0,0 +1,66 @@
+#include <stdio.h>
+#include <time.h>
+
+#include "alloc.h"
+#include "evaluator.h"
+#include "gc.h"
+
+// Instructions per run and runs timed, the best run is reported
+#define BENCH_GROUPS \
+    250000
+#define BENCH_RUNS \
+    40
+
+// Leaves its first argument as the result, so the intrinsic costs next to
+// nothing and the loop is all dispatch
+static void bench_keep(Owl_GC *gc, Owl_Stack *stack) {
+    (void)gc;
+    stack->length = 1;
+}
+
+static double bench_now(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec * 1e-9;
+}
+
+static double bench_run(Owl_Evaluator *eval, const Owl_Code code) {
+    double best = 0.0;
+    for (int run = 0; run < BENCH_RUNS; run++) {
+        eval->pc = 0;
+        eval->stack.length = 0;
+        const double started = bench_now();
+        owl_eval_code(eval, code);
+        const double elapsed = bench_now() - started;
+        if (run == 0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+    return best;
+}
+
+int main(void) {
+    Owl_GC gc = owl_gc_init(owl_default_alloc_init());
+    Owl_Evaluator eval = owl_eval_init(&gc);
+
+    Owl_Code code = owl_code_init(gc.alloc);
+    owl_code_push(&code, owl_value_number(0.0));
+    for (int i = 0; i < BENCH_GROUPS; i++) {
+        owl_code_resize_if_needed(&code);
+        code.code[code.length++] = (Owl_Opcode){.type = OWL_OP_NONE};
+        owl_code_push(&code, owl_value_number(1.0));
+        owl_code_push(&code, owl_value_number(2.0));
+        owl_code_syscall(&code, bench_keep, "keep", 3);
+    }
+
+    // Timed per source instruction, before and after fusing
+    const size_t instructions = code.length;
+    printf("dispatch: %zu instructions, %.2f ns each\n", instructions, bench_run(&eval, code) * 1e9 / (double)instructions);
+    owl_code_optimize(&code);
+    printf("optimized: %zu instructions, %.2f ns each\n", code.length, bench_run(&eval, code) * 1e9 / (double)instructions);
+
+    owl_code_deinit(&code);
+    owl_eval_deinit(&eval);
+    owl_gc_deinit(&gc);
+    return 0;
+}
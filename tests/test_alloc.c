@@ -0,0 +1,76 @@
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "alloc.h"
+#include "gc.h"
+
+int main(void) {
+    Owl_Slab slab = owl_slab_init();
+    Owl_Alloc alloc = owl_slab_alloc(&slab);
+
+    void *a = OWL_NEW(alloc, 24);
+    void *b = OWL_NEW(alloc, 24);
+    assert(a != NULL && b != NULL && a != b);
+    assert((uintptr_t)a % OWL_SLAB_GRANULE == 0);
+    memset(a, 0xAB, 24);
+    memset(b, 0xCD, 24);
+
+    Owl_SlabStats stats = owl_slab_stats(&slab);
+    assert(stats.allocations == 2);
+    assert(stats.bytes_in_use == 48);
+    assert(stats.blocks == 1);
+
+    // Freed chunks are reused by the next request of the same class
+    OWL_DEL(alloc, a);
+    void *c = OWL_NEW(alloc, 17);
+    assert(c == a);
+
+    void *large = OWL_NEW(alloc, OWL_SLAB_MAX_SIZE + 1);
+    assert(large != NULL);
+    OWL_DEL(alloc, large);
+
+    stats = owl_slab_stats(&slab);
+    assert(stats.frees == 1);
+    assert(stats.large_allocations == 1);
+    assert(stats.large_frees == 1);
+
+    OWL_DEL(alloc, b);
+    OWL_DEL(alloc, c);
+    assert(owl_slab_stats(&slab).bytes_in_use == 0);
+
+    Owl_GC gc = owl_gc_init(alloc);
+    Owl_Object *list = owl_new_list(&gc);
+    for (int i = 0; i < 2000; i++) {
+        owl_list_append(&gc, list, owl_new_number(&gc, (double)i));
+    }
+    assert(owl_slab_stats(&slab).large_allocations > 0);
+    owl_gc_deinit(&gc);
+    assert(owl_slab_stats(&slab).bytes_in_use == 0);
+
+    Owl_Arena arena = owl_arena_init(alloc);
+    Owl_Alloc scratch = owl_arena_alloc(&arena);
+
+    char *first = OWL_NEW(scratch, 10);
+    char *second = OWL_NEW(scratch, 10);
+    assert((uintptr_t)first % OWL_ARENA_ALIGNMENT == 0);
+    assert(second == first + OWL_ARENA_ALIGNMENT);
+    OWL_DEL(scratch, first);
+
+    Owl_ArenaMark mark = owl_arena_mark(&arena);
+    char *third = OWL_NEW(scratch, 32);
+    for (int i = 0; i < 4; i++) {
+        assert(OWL_NEW(scratch, OWL_ARENA_CHUNK_SIZE / 2) != NULL);
+    }
+    assert(OWL_NEW(scratch, OWL_ARENA_CHUNK_SIZE * 2) != NULL);
+    owl_arena_reset(&arena, mark);
+    assert(OWL_NEW(scratch, 32) == third);
+
+    owl_arena_reset(&arena, (Owl_ArenaMark){0});
+    assert(arena.chunk == NULL);
+    owl_arena_deinit(&arena);
+    assert(arena.spare == NULL);
+
+    owl_slab_deinit(&slab);
+    return 0;
+}
@@ -0,0 +1,151 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dict.h"
+#include "gc.h"
+
+static Owl_Object *string(Owl_GC *gc, const char *cstr) {
+    Owl_Object *object = owl_gc_new(gc, OWL_STRING);
+    object->string = (Owl_String){.data = (char *)cstr, .length = strlen(cstr), .owned = 0};
+    return object;
+}
+
+static void test_table(Owl_GC *gc) {
+    Owl_Object *dict = owl_new_dict(gc, 0);
+    owl_gc_add_root(gc, dict);
+    assert(dict->dict_slots == NULL);
+    assert(owl_dict_get(gc, dict, owl_new_number(gc, 1.0)) == NULL);
+
+    const size_t count = 5000;
+    for (size_t i = 0; i < count; i++) {
+        owl_dict_set(gc, dict, owl_new_number(gc, (double)i), owl_new_number(gc, (double)(i * 2)));
+    }
+    assert(dict->dict_length == count);
+    assert(dict->dict_length * 8 <= dict->dict_capacity * OWL_DICT_MAX_LOAD);
+
+    // Keys compare by value, not by object
+    for (size_t i = 0; i < count; i++) {
+        assert(owl_dict_get(gc, dict, owl_new_number(gc, (double)i))->number == (double)(i * 2));
+    }
+    assert(owl_dict_get(gc, dict, owl_new_number(gc, -0.0)) == owl_dict_get(gc, dict, owl_new_number(gc, 0.0)));
+    owl_dict_set(gc, dict, owl_new_number(gc, 7.0), owl_new_number(gc, -7.0));
+    assert(dict->dict_length == count);
+    assert(owl_dict_get(gc, dict, owl_new_number(gc, 7.0))->number == -7.0);
+
+    owl_dict_set(gc, dict, owl_new_symbol(gc, "name"), string(gc, "owl"));
+    owl_dict_set(gc, dict, string(gc, "key"), owl_new_symbol(gc, "value"));
+    assert(owl_dict_get(gc, dict, string(gc, "key")) == owl_new_symbol(gc, "value"));
+    assert(OWL_TYPE(owl_dict_get(gc, dict, owl_new_symbol(gc, "name"))) == OWL_STRING);
+    assert(owl_dict_get(gc, dict, string(gc, "name")) == NULL);
+
+    // Removal shifts the rest of each run back, so every probe still ends
+    // at the first slot that is empty or closer to home
+    for (size_t i = 0; i < count; i += 2) {
+        assert(owl_dict_remove(gc, dict, owl_new_number(gc, (double)i)) == T);
+    }
+    assert(owl_dict_remove(gc, dict, owl_new_number(gc, 0.0)) == F);
+    assert(dict->dict_length == count / 2 + 2);
+    for (size_t i = 0; i < count; i++) {
+        Owl_Object *value = owl_dict_get(gc, dict, owl_new_number(gc, (double)i));
+        assert((i % 2 == 0) == (value == NULL));
+    }
+
+    size_t cursor = 0;
+    size_t seen = 0;
+    Owl_Object *key = NULL;
+    Owl_Object *value = NULL;
+    while (owl_dict_next(dict, &cursor, &key, &value) == T) {
+        assert(key != NULL && value != NULL);
+        seen++;
+    }
+    assert(seen == dict->dict_length);
+
+    // Entries survive the nursery, a full collection and compaction
+    owl_gc_mark(gc);
+    owl_gc_sweep(gc);
+    owl_gc_finish_sweep(gc);
+    owl_dict_set(gc, dict, owl_new_number(gc, 1.5), owl_new_list(gc));
+    owl_gc_minor(gc);
+    owl_gc_mark(gc);
+    owl_gc_compact(gc);
+    assert(OWL_TYPE(owl_dict_get(gc, dict, owl_new_number(gc, 1.5))) == OWL_LIST);
+    assert(owl_dict_get(gc, dict, owl_new_number(gc, 4999.0))->number == 9998.0);
+    assert(owl_dict_get(gc, dict, string(gc, "key")) == owl_new_symbol(gc, "value"));
+
+    owl_gc_remove_root(gc, dict);
+}
+
+static void test_identity(Owl_GC *gc) {
+    Owl_Object *dict = owl_new_dict(gc, 0);
+    owl_gc_add_root(gc, dict);
+    const size_t count = 65536;
+    Owl_Object *keys = owl_new_array(gc, count);
+    owl_gc_add_root(gc, keys);
+
+    for (size_t i = 0; i < count; i++) {
+        // Unrelated allocations land between the keys, as they would in a
+        // real program
+        for (int skip = rand() % 4; skip > 0; skip--) {
+            owl_new_list(gc);
+        }
+        Owl_Object *key = owl_new_list(gc);
+        owl_array_set(gc, keys, i, key);
+        owl_dict_set(gc, dict, key, owl_new_number(gc, (double)i));
+    }
+    const uint32_t hash = OWL_GC_IDENTITY_HASH(keys->array[7]);
+
+    // Keys of one type spread out instead of sharing a probe sequence,
+    // even with far more keys than a narrow hash could tell apart
+    uint64_t total = 0;
+    for (size_t i = 0; i < dict->dict_capacity; i++) {
+        total += dict->dict_slots[i].distance;
+    }
+    assert(total < 2 * count);
+
+    // The hash stays with the object when it is copied out of the nursery
+    // and when the old space is compacted
+    owl_gc_minor(gc);
+    assert(OWL_GC_IDENTITY_HASH(keys->array[7]) == hash);
+    owl_gc_mark(gc);
+    owl_gc_compact(gc);
+    assert(OWL_GC_IDENTITY_HASH(keys->array[7]) == hash);
+    for (size_t i = 0; i < count; i++) {
+        assert(owl_dict_get(gc, dict, keys->array[i])->number == (double)i);
+    }
+    assert(owl_dict_get(gc, dict, owl_new_list(gc)) == NULL);
+
+    // Every NaN is the same key
+    owl_dict_set(gc, dict, owl_new_number(gc, __builtin_nan("")), owl_new_number(gc, 1.0));
+    owl_dict_set(gc, dict, owl_new_number(gc, -__builtin_nan("1")), owl_new_number(gc, 2.0));
+    assert(dict->dict_length == count + 1);
+    assert(owl_dict_get(gc, dict, owl_new_number(gc, __builtin_nan("")))->number == 2.0);
+    assert(owl_dict_remove(gc, dict, owl_new_number(gc, __builtin_nan(""))) == T);
+    assert(dict->dict_length == count);
+
+    owl_gc_remove_root(gc, keys);
+    owl_gc_remove_root(gc, dict);
+}
+
+static void test_presized(Owl_GC *gc) {
+    Owl_Object *dict = owl_new_dict(gc, 100);
+    const size_t capacity = dict->dict_capacity;
+    assert(capacity >= 100 && (capacity & (capacity - 1)) == 0);
+    char names[100][8];
+    for (int i = 0; i < 100; i++) {
+        snprintf(names[i], sizeof(names[i]), "k%d", i);
+        owl_dict_set(gc, dict, owl_new_symbol(gc, names[i]), owl_new_number(gc, (double)i));
+    }
+    assert(dict->dict_capacity == capacity);
+    assert(owl_dict_get(gc, dict, owl_new_symbol(gc, "k42"))->number == 42.0);
+}
+
+int main(void) {
+    Owl_GC gc = owl_gc_init(owl_default_alloc_init());
+    test_table(&gc);
+    test_identity(&gc);
+    test_presized(&gc);
+    owl_gc_deinit(&gc);
+    return 0;
+}
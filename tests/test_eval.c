@@ -1,9 +1,11 @@
 #include <assert.h>
+#include <stdio.h>
 #include <string.h>
 
 #include "alloc.h"
 #include "evaluator.h"
 #include "gc.h"
+#include "rope.h"
 
 static Owl_Object *build_script(Owl_GC *gc) {
     Owl_Object *script = owl_new_list(gc);
@@ -19,6 +21,316 @@ static Owl_Object *build_script(Owl_GC *gc) {
     return script;
 }
 
+static void test_intrinsic(Owl_GC *gc, Owl_Stack *stack) {
+    owl_stack_push(stack, OWL_VALUE_TRUE, gc->alloc);
+}
+
+static void test_make(Owl_GC *gc, Owl_Stack *stack) {
+    Owl_Object *list = owl_new_list(gc);
+    owl_list_append(gc, list, owl_new_number(gc, 42.0));
+    owl_stack_push(stack, OWL_VALUE_OBJECT(list), gc->alloc);
+    // Collect at the next safepoint, while the list is only on the stack
+    gc->threshold = 0;
+}
+
+static void test_stack_roots(Owl_Evaluator *eval) {
+    Owl_GC *gc = eval->gc;
+    owl_add_intrinsic(eval, test_make, "make");
+    // Not pure, so the call stays and reaches the safepoint
+    owl_add_intrinsic(eval, owl_intrinsic_add, "add");
+
+    Owl_Object *script = owl_new_list(gc);
+    owl_gc_add_root(gc, script);
+    owl_list_append(gc, script, owl_new_symbol(gc, "do"));
+    Owl_Object *make = owl_new_list(gc);
+    owl_list_append(gc, make, owl_new_symbol(gc, "make"));
+    Owl_Object *constant = owl_new_list(gc);
+    owl_list_append(gc, constant, owl_new_number(gc, 7.0));
+    owl_list_append(gc, make, constant);
+    owl_list_append(gc, script, make);
+    Owl_Object *add = owl_new_list(gc);
+    owl_list_append(gc, add, owl_new_symbol(gc, "add"));
+    owl_list_append(gc, add, owl_new_number(gc, 1.0));
+    owl_list_append(gc, script, add);
+
+    const size_t roots = gc->root_length;
+    Owl_Code code = owl_compile(eval, script);
+    gc->step_budget_us = 0;
+    eval->pc = 0;
+    eval->stack.length = 0;
+    owl_eval_code(eval, code);
+    assert(gc->threshold >= OWL_GC_MIN_THRESHOLD);
+    assert(gc->root_length == roots + 1);
+
+    // The constant is rooted so it stays put, the made list was moved
+    assert(OWL_VALUE_AS_OBJECT(eval->stack.data[0]) == constant);
+    assert(code.code[0].value == OWL_VALUE_OBJECT(constant));
+    assert(constant->value->number == 7.0);
+    Owl_Object *made = OWL_VALUE_AS_OBJECT(eval->stack.data[1]);
+    assert(!owl_gc_is_young(gc, made) && OWL_GC_IS_LIVE(OWL_GC_GET_HEADER(made)));
+    assert(OWL_TYPE(made) == OWL_LIST && made->value->number == 42.0);
+    assert(owl_value_as_number(eval->stack.data[eval->stack.length - 1]) == 1.0);
+
+    owl_code_deinit(&code);
+    assert(gc->root_length == roots);
+    owl_gc_remove_root(gc, script);
+}
+
+static size_t young_count = 0;
+
+// Each list holds its own number, so a stale stack slot pointing into a
+// reused nursery shows up as the wrong number
+static void test_young(Owl_GC *gc, Owl_Stack *stack) {
+    Owl_Object *list = owl_new_list(gc);
+    owl_list_append(gc, list, owl_new_number(gc, (double)young_count++));
+    owl_stack_push(stack, OWL_VALUE_OBJECT(list), gc->alloc);
+}
+
+static void test_incremental_roots(Owl_Evaluator *eval) {
+    Owl_GC *gc = eval->gc;
+    owl_add_intrinsic(eval, test_young, "young");
+
+    const size_t count = 512;
+    Owl_Object *script = owl_new_list(gc);
+    owl_gc_add_root(gc, script);
+    owl_list_append(gc, script, owl_new_symbol(gc, "do"));
+    for (size_t i = 0; i < count; i++) {
+        Owl_Object *call = owl_new_list(gc);
+        owl_list_append(gc, call, owl_new_symbol(gc, "young"));
+        owl_list_append(gc, script, call);
+    }
+    Owl_Code code = owl_compile(eval, script);
+
+    // A cycle already in progress is advanced a slice at a time by the
+    // calls, the slice that finishes marking moves the young lists that
+    // only the stack holds
+    const uint64_t budget = gc->step_budget_us;
+    const size_t collections = gc->stats.collections;
+    const size_t minors = gc->stats.minor_collections;
+    gc->step_budget_us = 1;
+    owl_gc_step(gc, 0);
+    assert(gc->phase == OWL_GC_MARKING);
+    eval->pc = 0;
+    eval->stack.length = 0;
+    owl_eval_code(eval, code);
+    assert(gc->stats.collections > collections);
+    assert(gc->stats.minor_collections > minors);
+
+    assert(eval->stack.length == count);
+    for (size_t i = 0; i < count; i++) {
+        Owl_Object *made = OWL_VALUE_AS_OBJECT(eval->stack.data[i]);
+        assert(OWL_TYPE(made) == OWL_LIST && made->value->number == (double)i);
+    }
+
+    gc->step_budget_us = budget;
+    owl_code_deinit(&code);
+    owl_gc_remove_root(gc, script);
+}
+
+static void test_full_stack(Owl_GC *gc) {
+    // A fresh evaluator, so the stack starts out empty and fills up
+    Owl_Evaluator eval = owl_eval_init(gc);
+    Owl_Code code = owl_code_init(gc->alloc);
+    for (int i = 0; i < 16; i++) {
+        owl_code_push(&code, owl_value_number((double)i));
+    }
+    // Called with the stack full and its argument away from the bottom,
+    // the result has to land past the end
+    owl_code_syscall(&code, test_intrinsic, "test", 1);
+    owl_code_syscall(&code, test_intrinsic, "test", 0);
+
+    const Owl_Value result = owl_eval_code(&eval, code);
+    assert(result == OWL_VALUE_TRUE);
+    assert(eval.pc == code.length);
+    assert(eval.stack.length == 18 && eval.stack.capacity >= 18);
+    for (int i = 0; i < 16; i++) {
+        assert(owl_value_as_number(eval.stack.data[i]) == (double)i);
+    }
+
+    // Running from the end does nothing
+    owl_eval_code(&eval, code);
+    assert(eval.stack.length == 18);
+    owl_code_deinit(&code);
+    owl_eval_deinit(&eval);
+    assert(eval.stack.data == NULL);
+}
+
+static void test_optimize(Owl_Evaluator *eval) {
+    Owl_GC *gc = eval->gc;
+    Owl_Object *list = owl_new_list(gc);
+    owl_gc_add_root(gc, list);
+    const size_t roots = gc->root_length;
+
+    Owl_Code code = owl_code_init(gc->alloc);
+    code.gc = gc;
+    owl_code_resize_if_needed(&code);
+    code.code[code.length++] = (Owl_Opcode){.type = OWL_OP_NONE};
+    owl_code_push(&code, owl_value_number(1.0));
+    owl_code_push(&code, owl_value_number(2.0));
+    owl_code_push(&code, owl_value_number(3.0));
+    owl_code_syscall(&code, owl_intrinsic_add, "+", 3);
+    owl_code_push(&code, owl_value_number(4.0));
+    owl_code_syscall(&code, owl_intrinsic_sub, "-", 2);
+    owl_code_push(&code, owl_value_number(5.0));
+    owl_code_push(&code, owl_value_number(6.0));
+    owl_code_push(&code, owl_value_number(7.0));
+    owl_code_push(&code, owl_value_number(8.0));
+    owl_code_push(&code, owl_value_number(9.0));
+    owl_code_syscall(&code, owl_intrinsic_mul, "*", 0);
+    // Pushed objects stay rooted however they are fused
+    owl_gc_add_root(gc, list);
+    owl_code_push(&code, OWL_VALUE_OBJECT(list));
+    owl_code_syscall(&code, test_intrinsic, "test", 1);
+    owl_code_push(&code, owl_value_number(10.0));
+    owl_code_push(&code, owl_value_number(11.0));
+    owl_code_syscall(&code, owl_intrinsic_sub, "-", 2);
+
+    eval->pc = 0;
+    eval->stack.length = 0;
+    assert(owl_value_as_number(owl_eval_code(eval, code)) == -1.0);
+    Owl_Value plain[32];
+    const size_t depth = eval->stack.length;
+    assert(depth == 17);
+    memcpy(plain, eval->stack.data, depth * sizeof(Owl_Value));
+
+    assert(owl_code_optimize(&code) == 10);
+    assert(code.length == 8);
+    assert(code.code[0].type == OWL_OP_PUSH2);
+    assert(code.code[1].type == OWL_OP_PUSH_SYSCALL);
+    assert(code.code[2].type == OWL_OP_PUSH_SYSCALL);
+    assert(code.code[3].type == OWL_OP_PUSH2);
+    assert(code.code[4].type == OWL_OP_PUSH2);
+    assert(code.code[5].type == OWL_OP_PUSH_SYSCALL);
+    assert(code.code[6].type == OWL_OP_PUSH_SYSCALL);
+    assert(code.code[7].type == OWL_OP_PUSH2_SYSCALL);
+    assert(owl_code_optimize(&code) == 0);
+
+    Owl_String listing = owl_code_tostr(&code);
+    assert(strstr(owl_string_data(&listing), "PUSH2 1 2\nPUSH_SYSCALL 3 + argc=3\n") != NULL);
+    assert(strstr(owl_string_data(&listing), "PUSH_SYSCALL 4 - argc=2\n") != NULL);
+    owl_string_del(&listing, gc->alloc);
+
+    // The same results from fewer dispatches
+    eval->pc = 0;
+    eval->stack.length = 0;
+    assert(owl_value_as_number(owl_eval_code(eval, code)) == -1.0);
+    assert(eval->stack.length == depth);
+    assert(memcmp(eval->stack.data, plain, depth * sizeof(Owl_Value)) == 0);
+    assert(OWL_VALUE_AS_OBJECT(eval->stack.data[12]) == list);
+
+    owl_code_deinit(&code);
+    assert(gc->root_length == roots);
+    owl_gc_remove_root(gc, list);
+}
+
+static Owl_Object *call2(Owl_GC *gc, const char *name, Owl_Object *a, Owl_Object *b) {
+    Owl_Object *list = owl_new_list(gc);
+    owl_list_append(gc, list, owl_new_symbol(gc, name));
+    owl_list_append(gc, list, a);
+    owl_list_append(gc, list, b);
+    return list;
+}
+
+static void test_fold(Owl_Evaluator *eval) {
+    Owl_GC *gc = eval->gc;
+
+    Owl_Object *script = owl_new_list(gc);
+    owl_gc_add_root(gc, script);
+    owl_list_append(gc, script, owl_new_symbol(gc, "do"));
+    owl_list_append(gc, script, call2(gc, "*", owl_new_number(gc, 2.0), owl_new_number(gc, 3.5)));
+    owl_list_append(gc, script, call2(gc, "concat", owl_new_number(gc, 0.25), owl_new_number(gc, 1.0)));
+
+    const size_t roots = gc->root_length;
+    Owl_Code code = owl_compile(eval, script);
+    assert(code.length == 2);
+    assert(code.code[0].type == OWL_OP_PUSH && owl_value_as_number(code.code[0].value) == 7.0);
+    Owl_Object *text = OWL_VALUE_AS_OBJECT(code.code[1].value);
+    assert(gc->root_length == roots + 1);
+
+    // Survives a collection as part of the code
+    owl_gc_minor(gc);
+    owl_gc_mark(gc);
+    owl_gc_sweep(gc);
+    owl_gc_finish_sweep(gc);
+    text = owl_rope_flatten(gc, text);
+    assert(text->string.length == 5 && memcmp(owl_string_data(&text->string), "0.251", 5) == 0);
+
+    // Running it makes nothing
+    eval->pc = 0;
+    eval->stack.length = 0;
+    owl_stack_reserve(&eval->stack, 2, gc->alloc);
+    const size_t young = gc->young_bytes;
+    const size_t allocated = gc->allocated;
+    assert(OWL_VALUE_AS_OBJECT(owl_eval_code(eval, code)) == text);
+    assert(gc->young_bytes == young && gc->allocated == allocated);
+    owl_code_deinit(&code);
+    assert(gc->root_length == roots);
+
+    // Nested calls are data to the call around them, folded or not
+    Owl_Object *nested = owl_new_list(gc);
+    owl_gc_add_root(gc, nested);
+    owl_list_append(gc, nested, owl_new_symbol(gc, "do"));
+    Owl_Object *quoted = call2(gc, "-", owl_new_number(gc, 3.0), owl_new_number(gc, 1.0));
+    Owl_Object *concat = owl_new_list(gc);
+    owl_list_append(gc, concat, owl_new_symbol(gc, "concat"));
+    owl_list_append(gc, concat, quoted);
+    owl_list_append(gc, nested, concat);
+
+    code = owl_compile(eval, nested);
+    assert(code.length == 2);
+    assert(OWL_VALUE_AS_OBJECT(code.code[0].value) == quoted);
+    assert(code.code[1].type == OWL_OP_SYSCALL && code.code[1].intrinsic == owl_intrinsic_concat);
+    eval->pc = 0;
+    eval->stack.length = 0;
+    Owl_Object *printed = owl_rope_flatten(gc, OWL_VALUE_AS_OBJECT(owl_eval_code(eval, code)));
+    assert(printed->string.length == 7 && memcmp(owl_string_data(&printed->string), "(- 3 1)", 7) == 0);
+    owl_code_deinit(&code);
+
+    // Only number literals fold, other arguments are checked when it runs
+    Owl_Object *label = owl_new_string(gc, "x=", 2);
+    owl_list_append(gc, nested, call2(gc, "concat", label, owl_new_number(gc, 1.0)));
+    code = owl_compile(eval, nested);
+    assert(code.length == 5);
+    assert(OWL_VALUE_AS_OBJECT(code.code[2].value) == label);
+    assert(code.code[4].type == OWL_OP_SYSCALL);
+    owl_code_deinit(&code);
+
+    // Registering a name again resets its purity
+    owl_add_intrinsic(eval, owl_intrinsic_mul, "*");
+    code = owl_compile(eval, script);
+    assert(code.length == 4 && code.code[2].type == OWL_OP_SYSCALL);
+    owl_code_deinit(&code);
+    const Owl_NamedIntrinsic pure[] = {{.sym = "*", .fn = owl_intrinsic_mul, .pure = T}};
+    owl_add_intrinsics(eval, pure, 1);
+    assert(owl_find_intrinsic(eval, owl_new_symbol(gc, "*"))->pure == T);
+
+    owl_gc_remove_root(gc, nested);
+    owl_gc_remove_root(gc, script);
+}
+
+static void test_registry(Owl_Evaluator *eval) {
+    char names[300][16];
+    Owl_NamedIntrinsic entries[300];
+    for (int i = 0; i < 300; i++) {
+        snprintf(names[i], sizeof(names[i]), "host-%d", i);
+        entries[i] = (Owl_NamedIntrinsic){.sym = names[i], .fn = test_intrinsic};
+    }
+    const size_t before = eval->intrinsics.length;
+    owl_add_intrinsics(eval, entries, 300);
+    assert(eval->intrinsics.length == before + 300);
+
+    for (int i = 0; i < 300; i++) {
+        assert(owl_get_intrinsic(eval, owl_new_symbol(eval->gc, names[i])) == test_intrinsic);
+    }
+    assert(owl_get_intrinsic(eval, owl_new_symbol(eval->gc, "+")) == owl_intrinsic_add);
+    assert(owl_get_intrinsic(eval, owl_new_symbol(eval->gc, "missing")) == NULL);
+    assert(owl_get_intrinsic(eval, owl_new_number(eval->gc, 1.0)) == NULL);
+
+    owl_add_intrinsic(eval, owl_intrinsic_sub, "host-7");
+    assert(eval->intrinsics.length == before + 300);
+    assert(owl_get_intrinsic(eval, owl_new_symbol(eval->gc, "host-7")) == owl_intrinsic_sub);
+}
+
 int main(void) {
     Owl_Alloc alloc = owl_default_alloc_init();
     Owl_GC gc = owl_gc_init(alloc);
@@ -28,18 +340,36 @@ int main(void) {
 
     Owl_Evaluator eval = owl_eval_init(&gc);
     Owl_Code code = owl_compile(&eval, script);
-    assert(code.length == 4);
+    assert(code.length == 1);
 
     Owl_String bytecode = owl_code_tostr(&code);
-    assert(strstr(bytecode.data, "SYSCALL + argc=3") != NULL);
+    assert(strcmp(owl_string_data(&bytecode), "PUSH 6\n") == 0);
     owl_string_del(&bytecode, alloc);
 
-    Owl_Object *result = owl_eval_code(&eval, code);
-    assert(result != NULL);
-    assert(result->type == OWL_NUMBER);
-    assert(result->number == 6.0);
+    Owl_Value result = owl_eval_code(&eval, code);
+    assert(OWL_VALUE_IS_NUMBER(result));
+    assert(owl_value_as_number(result) == 6.0);
 
     owl_code_deinit(&code);
+
+    Owl_Arena arena = owl_arena_init(alloc);
+    Owl_ArenaMark mark = owl_arena_mark(&arena);
+    for (int i = 0; i < 4; i++) {
+        Owl_Code scratch_code = owl_compile_with(&eval, script, owl_arena_alloc(&arena));
+        assert(scratch_code.length == 1);
+        Owl_String listing = owl_code_tostr(&scratch_code);
+        assert(strstr(owl_string_data(&listing), "PUSH 6") != NULL);
+        owl_arena_reset(&arena, mark);
+    }
+    owl_arena_deinit(&arena);
+
+    test_registry(&eval);
+    test_stack_roots(&eval);
+    test_incremental_roots(&eval);
+    test_full_stack(&gc);
+    test_optimize(&eval);
+    test_fold(&eval);
+
     owl_eval_deinit(&eval);
     owl_gc_mark(&gc);
     owl_gc_sweep(&gc);
@@ -1,7 +1,420 @@
 #include <assert.h>
+#include <stdio.h>
+#include <string.h>
 
 #include "gc.h"
 
+static void test_long_list(Owl_GC *gc) {
+    // Deep enough to overflow the native stack if marking recursed on next
+    const size_t length = 1000000;
+    Owl_Object *head = owl_new_list(gc);
+    Owl_Object *tail = head;
+    head->value = owl_new_number(gc, 0.0);
+    for (size_t i = 1; i < length; i++) {
+        Owl_Object *node = owl_new_list(gc);
+        node->value = owl_new_number(gc, (double)i);
+        tail->next = node;
+        tail = node;
+    }
+
+    Owl_Object *nested = owl_new_list(gc);
+    nested->value = head;
+    owl_gc_add_root(gc, nested);
+
+    owl_gc_mark(gc);
+    // Only the root kept its address, the list itself was copied
+    size_t count = 0;
+    Owl_Object *it = nested->value;
+    while (it->next != NULL) {
+        assert(it->value->number == (double)count);
+        it = it->next;
+        count++;
+    }
+    assert(count == length - 1);
+    assert(!owl_gc_is_young(gc, it));
+    assert(owl_gc_is_marked(gc, it));
+    assert(owl_gc_is_marked(gc, it->value));
+    assert(gc->mark_stack.length == 0);
+    assert(gc->mark_stack.capacity <= OWL_MARK_STACK_CAPACITY);
+    assert(gc->promoted.capacity <= OWL_MARK_STACK_CAPACITY);
+    owl_gc_sweep(gc);
+    owl_gc_finish_sweep(gc);
+    assert(OWL_GC_IS_LIVE(OWL_GC_GET_HEADER(it)));
+}
+
+static void test_nursery(Owl_GC *gc) {
+    Owl_Object *list = owl_new_list(gc);
+    owl_gc_add_root(gc, list);
+    owl_list_append(gc, list, owl_new_number(gc, 1.0));
+    Owl_Object *first = list->value;
+    Owl_Object *pinned = owl_new_number(gc, 7.0);
+    owl_gc_pin(gc, pinned);
+    Owl_Object *dead = owl_new_array(gc, 4);
+    assert(owl_gc_is_young(gc, list) && owl_gc_is_young(gc, first));
+
+    owl_gc_minor(gc);
+    assert(gc->young_bytes == 0);
+    assert(!owl_gc_is_young(gc, list) && !owl_gc_is_young(gc, pinned));
+    assert(pinned->number == 7.0);
+    assert(list->value != first && !owl_gc_is_young(gc, list->value));
+    assert(list->value->number == 1.0);
+
+    // Nothing in the array's block survived, so the block is reused
+    assert(owl_new_array(gc, 1) == dead);
+
+    // Storing a young object into the now old list goes through the barrier
+    owl_list_append(gc, list, owl_new_number(gc, 2.0));
+    assert((OWL_GC_GET_HEADER(list)->word & OWL_GC_REMEMBERED_BIT) != 0);
+    assert(gc->remembered.length == 1);
+    owl_gc_minor(gc);
+    assert(gc->remembered.length == 0);
+    assert(list->next != NULL && !owl_gc_is_young(gc, list->next));
+    assert(list->next->value->number == 2.0);
+
+    // Promoted objects are reclaimed by the old space collector
+    Owl_Object *old = list->value;
+    list->value = owl_new_number(gc, 3.0);
+    owl_gc_write_barrier(gc, list, list->value);
+    owl_gc_mark(gc);
+    assert(!owl_gc_is_marked(gc, old));
+    owl_gc_sweep(gc);
+    owl_gc_finish_sweep(gc);
+    assert(!OWL_GC_IS_LIVE(OWL_GC_GET_HEADER(old)));
+    assert(list->value->number == 3.0);
+}
+
+static void test_incremental(Owl_GC *gc) {
+    const size_t length = 100000;
+    Owl_Object *list = owl_new_list(gc);
+    Owl_Object *tail = list;
+    list->value = owl_new_number(gc, 0.0);
+    for (size_t i = 1; i < length; i++) {
+        Owl_Object *node = owl_new_list(gc);
+        node->value = owl_new_number(gc, (double)i);
+        tail->next = node;
+        tail = node;
+    }
+    Owl_Object *holder = owl_new_list(gc);
+    owl_gc_add_root(gc, list);
+    owl_gc_add_root(gc, holder);
+    owl_gc_minor(gc);
+
+    assert(owl_gc_step(gc, 0) == F);
+    assert(gc->phase == OWL_GC_MARKING);
+
+    // Move the last node into the already marked holder and drop the one
+    // before it, the barrier has to shade the moved node
+    Owl_Object *it = list;
+    while (it->next->next->next != NULL) {
+        it = it->next;
+    }
+    Owl_Object *dropped = it->next;
+    Owl_Object *moved = dropped->next;
+    it->next = NULL;
+    assert(owl_gc_is_marked(gc, holder) && !owl_gc_is_marked(gc, moved));
+    holder->value = moved;
+    owl_gc_write_barrier(gc, holder, moved);
+    assert(owl_gc_is_marked(gc, moved));
+
+    // Young objects stored while marking survive through the nursery
+    owl_list_append(gc, holder, owl_new_number(gc, 5.0));
+
+    size_t steps = 1;
+    while (owl_gc_step(gc, 0) == F) {
+        steps++;
+    }
+    assert(steps > 2);
+    assert(gc->phase == OWL_GC_IDLE);
+    assert(OWL_GC_IS_LIVE(OWL_GC_GET_HEADER(moved)));
+    assert(OWL_GC_IS_LIVE(OWL_GC_GET_HEADER(it)));
+    assert(!OWL_GC_IS_LIVE(OWL_GC_GET_HEADER(dropped)));
+    assert(moved->value->number == (double)(length - 1));
+    assert(holder->next->value->number == 5.0);
+}
+
+static void test_parallel_mark(void) {
+    Owl_GC gc = owl_gc_init_with(owl_default_alloc_init(), (Owl_GC_Options){.mark_threads = 4});
+    const size_t width = 20000;
+    Owl_Object *array = owl_new_array(&gc, width);
+    owl_gc_add_root(&gc, array);
+    for (size_t i = 0; i < width; i++) {
+        Owl_Object *list = owl_new_list(&gc);
+        for (int j = 0; j < 8; j++) {
+            owl_list_append(&gc, list, owl_new_number(&gc, (double)(i + j)));
+        }
+        owl_array_set(&gc, array, i, list);
+    }
+
+    owl_gc_mark(&gc);
+    Owl_Object *detached = array->array[0];
+    array->array[0] = NULL;
+    owl_gc_sweep(&gc);
+
+    owl_gc_mark(&gc);
+    assert(!owl_gc_is_marked(&gc, detached));
+    for (size_t i = 1; i < width; i++) {
+        size_t count = 0;
+        OWL_EACH(it, array->array[i]) {
+            assert(owl_gc_is_marked(&gc, it) && owl_gc_is_marked(&gc, it->value));
+            assert(it->value->number == (double)(i + count));
+            count++;
+        }
+        assert(count == 8);
+    }
+    owl_gc_sweep(&gc);
+    owl_gc_finish_sweep(&gc);
+    assert(!OWL_GC_IS_LIVE(OWL_GC_GET_HEADER(detached)));
+
+    owl_gc_deinit(&gc);
+}
+
+static void test_background_sweep(void) {
+    Owl_GC gc = owl_gc_init_with(owl_default_alloc_init(), (Owl_GC_Options){.mark_threads = 1, .background_sweep = T});
+    const size_t width = 5000;
+    Owl_Object *array = owl_new_array(&gc, width);
+    owl_gc_add_root(&gc, array);
+    for (size_t i = 0; i < width; i++) {
+        Owl_Object *list = owl_new_list(&gc);
+        owl_list_append(&gc, list, owl_new_array(&gc, 4));
+        owl_list_append(&gc, list, owl_new_number(&gc, (double)i));
+        owl_array_set(&gc, array, i, list);
+    }
+    owl_gc_mark(&gc);
+    owl_gc_sweep(&gc);
+
+    // Drop every other list while the sweeper may still be running, then
+    // keep allocating so the mutator competes with it for blocks
+    Owl_Object *dropped = array->array[0];
+    for (size_t i = 0; i < width; i += 2) {
+        array->array[i] = NULL;
+    }
+    for (int round = 0; round < 3; round++) {
+        owl_gc_mark(&gc);
+        owl_gc_sweep(&gc);
+        for (size_t i = 0; i < width; i += 2) {
+            owl_array_set(&gc, array, i, owl_new_number(&gc, (double)round));
+        }
+        owl_gc_minor(&gc);
+    }
+    owl_gc_finish_sweep(&gc);
+    assert(gc.phase == OWL_GC_IDLE);
+    assert(!OWL_GC_IS_LIVE(OWL_GC_GET_HEADER(dropped)));
+    for (size_t i = 1; i < width; i += 2) {
+        assert(array->array[i]->next->value->number == (double)i);
+        assert(OWL_TYPE(array->array[i]->value) == OWL_ARRAY);
+    }
+    assert(array->array[2]->number == 2.0);
+
+    owl_gc_deinit(&gc);
+}
+
+static void test_automatic(void) {
+    Owl_GC gc = owl_gc_init_with(owl_default_alloc_init(), (Owl_GC_Options){.mark_threads = 1, .growth_factor = 1.5});
+    gc.step_budget_us = 0;
+    assert(gc.growth_factor == 1.5);
+
+    // Constant live data and a steady stream of garbage keep the heap at a
+    // fixed size when collections only happen at safepoints
+    Owl_Object *array = owl_new_array(&gc, 20000);
+    owl_gc_add_root(&gc, array);
+    size_t blocks = 0;
+    for (int round = 0; round < 60; round++) {
+        for (size_t i = 0; i < 20000; i++) {
+            Owl_Object *list = owl_new_list(&gc);
+            list->value = owl_new_number(&gc, (double)i);
+            owl_array_set(&gc, array, i, list);
+        }
+        owl_gc_safepoint(&gc);
+        if (round == 30) {
+            blocks = gc.blocks.length;
+        }
+    }
+    assert(gc.blocks.length <= blocks);
+    assert(gc.live_bytes > 0 && gc.threshold >= OWL_GC_MIN_THRESHOLD);
+    assert(OWL_TYPE(array->array[999]) == OWL_LIST);
+
+    owl_gc_deinit(&gc);
+}
+
+static void count_cycle(Owl_GC *gc, const Owl_GC_Cycle *cycle, void *context) {
+    Owl_GC_Cycle *seen = context;
+    assert(cycle == &gc->stats.last);
+    *seen = *cycle;
+}
+
+static void test_stats(void) {
+    Owl_GC gc = owl_gc_init_with(owl_default_alloc_init(), (Owl_GC_Options){.mark_threads = 1, .background_sweep = T});
+    Owl_GC_Cycle seen = {0};
+    owl_gc_on_cycle(&gc, count_cycle, &seen);
+
+    Owl_Object *list = owl_new_list(&gc);
+    owl_gc_add_root(&gc, list);
+    for (int i = 0; i < 1000; i++) {
+        owl_list_append(&gc, list, owl_new_number(&gc, (double)i));
+    }
+    Owl_GC_Stats stats = owl_gc_stats(&gc);
+    assert(stats.objects_allocated[OWL_NUMBER] == 1000);
+    assert(stats.objects_allocated[OWL_LIST] == 1000);
+    assert(stats.bytes_allocated[OWL_NUMBER] == 1000 * owl_gc_object_size(OWL_NUMBER));
+    assert(stats.objects_allocated[OWL_NOTHING] == 1);
+
+    // The first cycle copies everything out of the nursery, the second one
+    // frees the half of the list that was cut off
+    owl_gc_mark(&gc);
+    owl_gc_sweep(&gc);
+    owl_gc_finish_sweep(&gc);
+    assert(seen.number == 1 && seen.freed_objects == 0);
+    assert(seen.surviving_objects == 2000);
+    Owl_Object *middle = list;
+    for (int i = 1; i < 500; i++) {
+        middle = middle->next;
+    }
+    middle->next = NULL;
+    owl_gc_mark(&gc);
+    owl_gc_sweep(&gc);
+    owl_gc_finish_sweep(&gc);
+    assert(seen.number == 2);
+    assert(seen.surviving_objects == 1000);
+    assert(seen.freed_objects == 1000);
+    assert(seen.freed_bytes == 500 * (owl_gc_object_size(OWL_NUMBER) + owl_gc_object_size(OWL_LIST)));
+
+    stats = owl_gc_stats(&gc);
+    assert(stats.collections == 2 && stats.minor_collections == 1);
+    assert(stats.promoted_bytes == stats.young_bytes);
+    assert(stats.freed_objects == 1000);
+    assert(stats.mark.count == 2 && stats.sweep.count == 2);
+    size_t counted = 0;
+    for (size_t i = 0; i < OWL_GC_HISTOGRAM_BUCKETS; i++) {
+        counted += stats.mark.buckets[i];
+    }
+    assert(counted == 2 && stats.mark.max_ns <= stats.mark.total_ns);
+
+    // Pauses are only recorded when a safepoint has work to do
+    owl_gc_safepoint(&gc);
+    assert(gc.stats.pause.count == 0);
+    gc.threshold = 0;
+    gc.step_budget_us = 0;
+    owl_gc_safepoint(&gc);
+    assert(gc.stats.pause.count == 1 && seen.number == 3);
+
+    owl_gc_deinit(&gc);
+}
+
+static void scan_slot(Owl_GC *gc, void *context) {
+    owl_gc_visit(gc, context);
+}
+
+static size_t old_blocks(const Owl_GC *gc) {
+    size_t count = 0;
+    for (size_t i = 0; i < gc->blocks.length; i++) {
+        count += (gc->blocks.data[i]->young == F ? 1 : 0);
+    }
+    return count;
+}
+
+static void test_compact(void) {
+    Owl_GC gc = owl_gc_init(owl_default_alloc_init());
+
+    Owl_Object *list = owl_new_list(&gc);
+    owl_gc_add_root(&gc, list);
+    Owl_Object *pinned = owl_new_number(&gc, -1.0);
+    owl_gc_pin(&gc, pinned);
+    Owl_Object *tail = list;
+    list->value = owl_new_number(&gc, 0.0);
+    for (int i = 1; i < 80000; i++) {
+        Owl_Object *node = owl_new_list(&gc);
+        node->value = owl_new_number(&gc, (double)(i / 4));
+        tail->next = node;
+        tail = node;
+    }
+    owl_gc_mark(&gc);
+    owl_gc_sweep(&gc);
+    owl_gc_finish_sweep(&gc);
+
+    // Dropping three nodes out of four leaves every old block mostly empty
+    for (Owl_Object *node = list; node != NULL; node = node->next) {
+        Owl_Object *skip = node;
+        for (int j = 0; j < 3 && skip != NULL; j++) {
+            skip = skip->next;
+        }
+        node->next = (skip != NULL ? skip->next : NULL);
+    }
+    Owl_Object *array = owl_new_array(&gc, 2);
+    owl_array_set(&gc, array, 0, list->next);
+    Owl_Value slot = OWL_VALUE_OBJECT(array);
+    owl_gc_add_scanner(&gc, scan_slot, &slot);
+    owl_gc_mark(&gc);
+    owl_gc_sweep(&gc);
+    owl_gc_finish_sweep(&gc);
+    const size_t sparse = old_blocks(&gc);
+
+    owl_gc_mark(&gc);
+    owl_gc_compact(&gc);
+    assert(gc.phase == OWL_GC_IDLE);
+    assert(old_blocks(&gc) < sparse / 2);
+    assert(owl_gc_stats(&gc).last.number == 3);
+
+    // Survivors keep their order, so the list now runs through adjacent slots
+    size_t count = 0;
+    size_t adjacent = 0;
+    for (Owl_Object *node = list; node != NULL; node = node->next) {
+        assert(node->value->number == (double)count);
+        if ((char *)node->next == (char *)node + owl_gc_object_size(OWL_LIST)) {
+            adjacent++;
+        }
+        count++;
+    }
+    assert(count == 20000 && adjacent > count * 9 / 10);
+    assert(gc.stats.last.freed_objects == 0);
+    assert(pinned->number == -1.0 && OWL_IS_PINNED(pinned));
+    Owl_Object *moved = OWL_VALUE_AS_OBJECT(slot);
+    assert(OWL_TYPE(moved) == OWL_ARRAY && moved->array[0] == list->next);
+
+    // The freed blocks are gone and the remaining ones still allocate
+    for (int i = 0; i < 1000; i++) {
+        owl_list_append(&gc, list, owl_new_number(&gc, 1.0));
+    }
+    owl_gc_mark(&gc);
+    owl_gc_compact(&gc);
+    count = 0;
+    for (Owl_Object *node = list; node != NULL; node = node->next) {
+        count++;
+    }
+    assert(count == 21000);
+
+    owl_gc_remove_scanner(&gc, scan_slot, &slot);
+    owl_gc_deinit(&gc);
+}
+
+static void test_list_builder(Owl_GC *gc) {
+    Owl_ListBuilder builder = owl_list_builder(gc);
+    owl_gc_add_root(gc, builder.head);
+    for (int i = 0; i < 100000; i++) {
+        owl_list_builder_append(gc, &builder, owl_new_number(gc, (double)i));
+    }
+    assert(builder.length == 100000 && builder.tail->next == NULL);
+
+    // Resuming after a collection moved the tail
+    owl_gc_minor(gc);
+    builder = owl_list_builder_from(builder.head);
+    assert(builder.length == 100000);
+    owl_list_builder_append(gc, &builder, owl_new_number(gc, 100000.0));
+    owl_list_append(gc, builder.head, owl_new_number(gc, 100001.0));
+
+    size_t count = 0;
+    OWL_EACH(node, builder.head) {
+        assert(node->value->number == (double)count);
+        count++;
+    }
+    assert(count == 100002);
+    owl_gc_remove_root(gc, builder.head);
+
+    Owl_ListBuilder empty = owl_list_builder_from(owl_new_list(gc));
+    assert(empty.length == 0);
+    owl_list_builder_append(gc, &empty, owl_new_number(gc, 1.0));
+    assert(empty.head == empty.tail && empty.head->value->number == 1.0);
+}
+
 int main(void) {
     Owl_Alloc alloc = owl_default_alloc_init();
     Owl_GC gc = owl_gc_init(alloc);
@@ -9,17 +422,66 @@ int main(void) {
     Owl_Object *rooted = owl_new_number(&gc, 1.0);
     Owl_Object *unrooted = owl_new_number(&gc, 2.0);
 
-    OWL_GC_GET_HEADER(rooted)->pinned = F;
-    OWL_GC_GET_HEADER(unrooted)->pinned = F;
+    assert(OWL_TYPE(rooted) == OWL_NUMBER);
+    assert(!OWL_IS_PINNED(rooted) && !OWL_IS_PINNED(unrooted));
+    assert(OWL_IS_PINNED(gc.nothing));
+
+    assert(owl_gc_object_size(OWL_NUMBER) == sizeof(Owl_GC_Header) + sizeof(double));
+    assert(owl_gc_object_size(OWL_LIST) == sizeof(Owl_GC_Header) + 2 * sizeof(void *));
 
     owl_gc_add_root(&gc, rooted);
     owl_gc_mark(&gc);
+    assert(!owl_gc_is_young(&gc, rooted) && rooted->number == 1.0);
+    assert(owl_gc_is_marked(&gc, rooted) && !owl_gc_is_marked(&gc, unrooted));
+    assert(!OWL_GC_IS_LIVE(OWL_GC_GET_HEADER(unrooted)));
+
+    // Objects promoted while the mark bits are valid are born marked
+    Owl_Object *born_marked = owl_new_number(&gc, 3.0);
+    owl_gc_add_root(&gc, born_marked);
+    owl_gc_minor(&gc);
+    assert(owl_gc_is_marked(&gc, born_marked));
+
     owl_gc_sweep(&gc);
+    assert(gc.phase == OWL_GC_SWEEPING);
+    assert(OWL_GC_IS_LIVE(OWL_GC_GET_HEADER(rooted)));
+    assert(OWL_GC_IS_LIVE(OWL_GC_GET_HEADER(born_marked)));
+    owl_gc_finish_sweep(&gc);
+    assert(gc.phase == OWL_GC_IDLE);
 
-    Owl_GC_Header *head = gc.heap;
-    assert(OWL_GC_OBJECT_FROM_HEADER(head) == rooted);
-    assert(head->next == OWL_GC_GET_HEADER(gc.nothing));
-    assert(OWL_GC_GET_HEADER(rooted)->marked == F);
+    char name[] = "symbol";
+    Owl_Object *symbol = owl_new_symbol(&gc, name);
+    name[0] = 'S';
+    assert(owl_new_symbol(&gc, "symbol") == symbol);
+    assert(strcmp(symbol->symbol.data, "symbol") == 0);
+    assert(owl_intern_symbol(&gc, "symbols", 6) == symbol);
+    assert(owl_new_symbol(&gc, name) != symbol);
+    assert(OWL_IS_PINNED(symbol));
+
+    char buffer[16];
+    for (int i = 0; i < 200; i++) {
+        snprintf(buffer, sizeof(buffer), "s%d", i);
+        Owl_Object *interned = owl_new_symbol(&gc, buffer);
+        assert(interned->symbol.id == gc.symbols.length - 1);
+    }
+    assert(owl_new_symbol(&gc, "symbol") == symbol);
+    assert(owl_new_symbol(&gc, "s150")->symbol.id == symbol->symbol.id + 152);
+
+    test_long_list(&gc);
+    test_nursery(&gc);
+    test_list_builder(&gc);
+    test_incremental(&gc);
+    test_parallel_mark();
+    test_background_sweep();
+    test_automatic();
+    test_stats();
+    test_compact();
+
+    Owl_Object *array = owl_new_array(&gc, 2);
+    array->array[1] = owl_new_number(&gc, 3.0);
+    owl_gc_add_root(&gc, array);
+    owl_gc_mark(&gc);
+    assert(owl_gc_is_marked(&gc, array->array[1]));
+    owl_gc_sweep(&gc);
 
     owl_gc_deinit(&gc);
     return 0;
@@ -0,0 +1,167 @@
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gc.h"
+#include "numbers.h"
+
+static void assert_format(const double value, const char *expected) {
+    char buffer[OWL_NUMBER_BUFFER];
+    const size_t length = owl_number_format(value, buffer);
+    assert(length == strlen(expected) && strcmp(buffer, expected) == 0);
+}
+
+static double parse(const char *text, const size_t expected_length) {
+    double value = -1.0;
+    assert(owl_number_parse(text, strlen(text), &value) == expected_length);
+    return value;
+}
+
+static void test_format(void) {
+    assert_format(0.0, "0");
+    assert_format(-0.0, "-0");
+    assert_format(1.0, "1");
+    assert_format(-2.5, "-2.5");
+    assert_format(0.1, "0.1");
+    assert_format(1.0 / 3.0, "0.3333333333333333");
+    assert_format(123456789.0, "123456789");
+    assert_format(1e20, "100000000000000000000");
+    assert_format(1e21, "1e+21");
+    assert_format(0.000001, "0.000001");
+    assert_format(1e-7, "1e-7");
+    assert_format(1.5e300, "1.5e+300");
+    assert_format(5e-324, "5e-324");
+    assert_format(1.7976931348623157e308, "1.7976931348623157e+308");
+    assert_format(2.2250738585072014e-308, "2.2250738585072014e-308");
+    // Grisu2 printed one digit too many for these
+    assert_format(2737.9880239520958, "2737.988023952096");
+    assert_format(636.2094763092269, "636.209476309227");
+    assert_format(-1.8305252769034021e+208, "-1.830525276903402e+208");
+    assert_format(INFINITY, "inf");
+    assert_format(-INFINITY, "-inf");
+    assert_format(NAN, "nan");
+}
+
+static void test_parse(void) {
+    assert(parse("42", 2) == 42.0);
+    assert(parse("-0.25", 5) == -0.25);
+    assert(signbit(parse("-0", 2)));
+    assert(parse("+.5", 3) == 0.5);
+    assert(parse("7.", 2) == 7.0);
+    assert(parse("1e3", 3) == 1000.0);
+    assert(parse("2.5E-3", 6) == 0.0025);
+    assert(parse("1e37", 4) == 1e37);
+    assert(parse("3e30", 4) == 3e30);
+    assert(parse("1e400", 5) == INFINITY);
+    assert(parse("1e-400", 6) == 0.0);
+    assert(parse("-inf", 4) == -INFINITY);
+    assert(isnan(parse("nan", 3)));
+
+    // Only the number is taken
+    assert(parse("12abc", 2) == 12.0);
+    assert(parse("1e", 1) == 1.0);
+    assert(parse("1e+)", 1) == 1.0);
+    parse("-", 0);
+    parse(".", 0);
+    parse("e5", 0);
+    parse("", 0);
+
+    // More digits than the significand holds, the rest is rounded right
+    assert(parse("9007199254740993", 16) == 9007199254740992.0);
+    assert(parse("9007199254740993.0000000000001", 30) == 9007199254740994.0);
+    assert(parse("123456789012345678901234567890", 30) == 1.2345678901234568e29);
+    assert(parse("0.00000000000000000000000000000000000000000001", 46) == 1e-44);
+    char digits[300];
+    memset(digits, '1', sizeof(digits) - 1);
+    digits[sizeof(digits) - 1] = '\0';
+    assert(parse(digits, sizeof(digits) - 1) == strtod(digits, NULL));
+}
+
+// Every formatted value parses back to the same bits
+static void test_round_trip(void) {
+    uint64_t state = 88172645463325252u;
+    char buffer[OWL_NUMBER_BUFFER];
+    for (int i = 0; i < 200000; i++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        double value;
+        memcpy(&value, &state, sizeof(value));
+        if (isnan(value)) continue;
+        if (i % 2 == 0) {
+            value = (double)(state % 1000000) / (double)(1 + (state >> 40) % 1000);
+        }
+
+        const size_t length = owl_number_format(value, buffer);
+        double back;
+        assert(owl_number_parse(buffer, length, &back) == length);
+        assert(memcmp(&back, &value, sizeof(value)) == 0);
+        assert(strtod(buffer, NULL) == value);
+    }
+}
+
+// Significant digits in the shortest printf precision that reads back
+static int shortest_digits(const double value) {
+    char text[OWL_NUMBER_BUFFER];
+    for (int precision = 1; precision < 17; precision++) {
+        snprintf(text, sizeof(text), "%.*e", precision - 1, value);
+        if (strtod(text, NULL) == value) return precision;
+    }
+    return 17;
+}
+
+static int significant_digits(const char *text) {
+    int count = 0;
+    int last = 0;
+    for (; *text != '\0' && *text != 'e'; text++) {
+        if (*text < '0' || *text > '9' || (count == 0 && *text == '0')) continue;
+        count++;
+        if (*text != '0') {
+            last = count;
+        }
+    }
+    return last;
+}
+
+// No shorter text reads back as the same value
+static void test_shortest(void) {
+    uint64_t state = 2463534242u;
+    char buffer[OWL_NUMBER_BUFFER];
+    for (int i = 0; i < 100000; i++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        double value;
+        memcpy(&value, &state, sizeof(value));
+        if (i % 2 == 0) {
+            value = (double)(state % 100000000) / (double)(1 + (state >> 40) % 100000);
+        }
+        if (!isfinite(value) || value == 0.0) continue;
+
+        owl_number_format(value, buffer);
+        assert(significant_digits(buffer) == shortest_digits(value));
+    }
+}
+
+static void test_tostring(void) {
+    Owl_GC gc = owl_gc_init(owl_default_alloc_init());
+    Owl_Object *array = owl_new_f64_array(&gc, 3);
+    array->f64[0] = 0.1;
+    array->f64[1] = 1234567.125;
+    array->f64[2] = -1e-9;
+    Owl_String string = owl_object_tostring(array, gc.alloc);
+    assert(strcmp(owl_string_data(&string), "#f64[0.1 1234567.125 -1e-9]") == 0);
+    owl_string_del(&string, gc.alloc);
+    owl_gc_deinit(&gc);
+}
+
+int main(void) {
+    test_format();
+    test_parse();
+    test_round_trip();
+    test_shortest();
+    test_tostring();
+    return 0;
+}
@@ -2,12 +2,13 @@
 #include <string.h>
 
 #include "alloc.h"
+#include "dict.h"
 #include "gc.h"
 #include "objects.h"
 
 static void assert_string(Owl_String string, const char *expected, Owl_Alloc alloc) {
     assert(string.length == strlen(expected));
-    assert(strncmp(string.data, expected, string.length) == 0);
+    assert(strncmp(owl_string_data(&string), expected, string.length) == 0);
     owl_string_del(&string, alloc);
 }
 
@@ -20,16 +21,25 @@ int main(void) {
     Owl_Object *n3 = owl_new_number(&gc, 3.0);
 
     Owl_Stack stack = {0};
-    owl_stack_push(&stack, n1, alloc);
-    owl_stack_push(&stack, n2, alloc);
-    owl_stack_push(&stack, n3, alloc);
+    owl_stack_push(&stack, OWL_VALUE_OBJECT(n1), alloc);
+    owl_stack_push(&stack, owl_value_from_object(n2), alloc);
+    owl_stack_push(&stack, OWL_VALUE_TRUE, alloc);
     assert(stack.length == 3);
-    assert(owl_stack_pop(&stack) == n3);
-    assert(owl_stack_pop(&stack) == n2);
-    assert(owl_stack_pop(&stack) == n1);
-    assert(owl_stack_pop(&stack) == NULL);
+    assert(owl_stack_pop(&stack) == OWL_VALUE_TRUE);
+    assert(owl_value_as_number(owl_stack_pop(&stack)) == 2.0);
+    assert(OWL_VALUE_AS_OBJECT(owl_stack_pop(&stack)) == n1);
+    assert(OWL_VALUE_IS_NOTHING(owl_stack_pop(&stack)));
     OWL_DEL(alloc, stack.data);
 
+    assert(OWL_VALUE_IS_NUMBER(owl_value_number(-1.5)));
+    assert(OWL_VALUE_IS_NUMBER(owl_value_number(0.0 / 0.0)));
+    assert(!OWL_VALUE_IS_NUMBER(OWL_VALUE_NOTHING));
+    assert(OWL_VALUE_IS_BOOLEAN(OWL_VALUE_FALSE) && !OWL_VALUE_IS_BOOLEAN(OWL_VALUE_NOTHING));
+    assert(OWL_VALUE_IS_OBJECT(OWL_VALUE_OBJECT(n3)) && !OWL_VALUE_IS_OBJECT(OWL_VALUE_TRUE));
+    assert(owl_value_from_object(gc.nothing) == OWL_VALUE_NOTHING);
+    assert_string(owl_value_tostring(owl_value_number(2.5), alloc), "2.5", alloc);
+    assert_string(owl_value_tostring(OWL_VALUE_OBJECT(n3), alloc), "3", alloc);
+
     assert_string(owl_object_tostring(n1, alloc), "1", alloc);
 
     Owl_Object *bool_true = owl_gc_new(&gc, OWL_BOOLEAN);
@@ -39,8 +49,8 @@ int main(void) {
     assert_string(owl_object_tostring(bool_true, alloc), "#f", alloc);
 
     Owl_Object *sym = owl_new_symbol(&gc, "sym");
-    assert(owl_check_symbol(sym, "sym") == T);
-    assert(owl_check_symbol(sym, "other") == F);
+    assert(owl_check_symbol(sym, owl_new_symbol(&gc, "sym")) == T);
+    assert(owl_check_symbol(sym, owl_new_symbol(&gc, "other")) == F);
     assert_string(owl_object_tostring(sym, alloc), "sym", alloc);
 
     Owl_Object *str_obj = owl_gc_new(&gc, OWL_STRING);
@@ -57,12 +67,21 @@ int main(void) {
     array->array[1] = owl_new_number(&gc, 8.5);
     assert_string(owl_object_tostring(array, alloc), "[7 8.5]", alloc);
 
-    Owl_Object *dict = owl_gc_new(&gc, OWL_DICT);
-    dict->dict_key = owl_new_symbol(&gc, "k");
-    dict->dict_value = owl_new_number(&gc, 9.0);
-    dict->dict_next = NULL;
+    Owl_Object *dict = owl_new_dict(&gc, 0);
+    assert_string(owl_object_tostring(dict, alloc), "{}", alloc);
+    owl_dict_set(&gc, dict, owl_new_symbol(&gc, "k"), owl_new_number(&gc, 9.0));
     assert_string(owl_object_tostring(dict, alloc), "{k = 9}", alloc);
 
+    // Stringifying is linear in the size of the output
+    Owl_ListBuilder builder = owl_list_builder(&gc);
+    for (size_t i = 0; i < 1000000; i++) {
+        owl_list_builder_append(&gc, &builder, owl_new_number(&gc, (double)(i % 10)));
+    }
+    Owl_String big = owl_object_tostring(builder.head, alloc);
+    assert(big.length == 2000001 && big.data[0] == '(' && big.data[big.length - 1] == ')');
+    assert(strncmp(big.data, "(0 1 2", 6) == 0);
+    owl_string_del(&big, alloc);
+
     owl_gc_deinit(&gc);
     return 0;
 }
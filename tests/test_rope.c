@@ -0,0 +1,131 @@
+#include <assert.h>
+#include <string.h>
+
+#include "dict.h"
+#include "intrinsics.h"
+#include "rope.h"
+
+static Owl_Object *string(Owl_GC *gc, const char *cstr) {
+    return owl_new_string(gc, cstr, strlen(cstr));
+}
+
+static void assert_flat(const Owl_Object *object, const char *expected) {
+    assert(OWL_TYPE(object) == OWL_STRING);
+    assert(object->string.length == strlen(expected));
+    assert(strcmp(owl_string_data(&object->string), expected) == 0);
+}
+
+static void test_small(Owl_GC *gc) {
+    Owl_Object *short_string = string(gc, "short");
+    assert(short_string->string.small);
+    assert(owl_string_data(&short_string->string) == short_string->string.bytes);
+    assert(!string(gc, "a string that is long")->string.small);
+
+    // Short results are copied rather than linked
+    Owl_Object *joined = owl_rope_concat(gc, short_string, string(gc, " one"));
+    assert_flat(joined, "short one");
+    assert(joined->string.small);
+    assert(owl_rope_concat(gc, joined, string(gc, "")) == joined);
+
+    Owl_Object *symbol = owl_new_symbol(gc, "name");
+    assert(symbol->symbol.data == symbol->symbol.bytes);
+    Owl_Object *long_symbol = owl_new_symbol(gc, "a-rather-long-symbol-name");
+    assert(long_symbol->symbol.data != long_symbol->symbol.bytes);
+    assert(owl_new_symbol(gc, "a-rather-long-symbol-name") == long_symbol);
+}
+
+static void test_append(Owl_GC *gc) {
+    const size_t count = 100000;
+    Owl_Object *holder = owl_new_array(gc, 1);
+    owl_gc_add_root(gc, holder);
+    owl_array_set(gc, holder, 0, string(gc, "start:"));
+    for (size_t i = 0; i < count; i++) {
+        owl_array_set(gc, holder, 0, owl_rope_concat(gc, holder->array[0], string(gc, (i % 2 == 0 ? "ab" : "cd"))));
+        if (i % 20000 == 0) {
+            owl_gc_minor(gc);
+        }
+    }
+    Owl_Object *rope = holder->array[0];
+    assert(OWL_TYPE(rope) == OWL_ROPE);
+    assert(owl_rope_length(rope) == 6 + count * 2);
+
+    // Ropes survive a full collection and compaction with their pieces
+    owl_gc_minor(gc);
+    owl_gc_mark(gc);
+    owl_gc_compact(gc);
+    rope = holder->array[0];
+
+    Owl_String printed = owl_object_tostring(rope, gc->alloc);
+    assert(printed.length == owl_rope_length(rope) + 2);
+    assert(strncmp(owl_string_data(&printed), "\"start:abcdab", 13) == 0);
+    owl_string_del(&printed, gc->alloc);
+
+    // Flattening keeps the object
+    assert(owl_rope_flatten(gc, rope) == rope);
+    assert(OWL_TYPE(rope) == OWL_STRING && rope->string.length == 6 + count * 2);
+    const char *data = owl_string_data(&rope->string);
+    assert(strncmp(data + rope->string.length - 6, "cdabcd", 7) == 0);
+    owl_gc_mark(gc);
+    owl_gc_sweep(gc);
+    owl_gc_finish_sweep(gc);
+    assert(owl_string_data(&holder->array[0]->string) == data);
+    owl_gc_remove_root(gc, holder);
+}
+
+static void test_prepend(Owl_GC *gc) {
+    // Ropes leaning right need the heap for their traversal stack
+    Owl_Object *rope = string(gc, "end");
+    for (int i = 0; i < 1000; i++) {
+        rope = owl_rope_concat(gc, string(gc, "0123456789abcdef"), rope);
+    }
+    assert(owl_rope_length(rope) == 16003);
+    owl_rope_flatten(gc, rope);
+    assert(strncmp(owl_string_data(&rope->string), "0123456789abcdef0123", 20) == 0);
+    assert(strcmp(owl_string_data(&rope->string) + 16000, "end") == 0);
+
+    // A flattened rope that dies young releases its buffer
+    Owl_Object *young = owl_rope_concat(gc, string(gc, "a string that is long"), string(gc, " and another"));
+    owl_rope_flatten(gc, young);
+    assert_flat(young, "a string that is long and another");
+    owl_gc_minor(gc);
+}
+
+static void test_keys(Owl_GC *gc) {
+    Owl_Object *dict = owl_new_dict(gc, 0);
+    Owl_Object *key = owl_rope_concat(gc, string(gc, "a key made of "), string(gc, "two parts"));
+    owl_dict_set(gc, dict, key, owl_new_number(gc, 1.0));
+    assert(OWL_TYPE(key) == OWL_STRING);
+    assert(owl_dict_get(gc, dict, string(gc, "a key made of two parts"))->number == 1.0);
+
+    Owl_Object *lookup = owl_rope_concat(gc, string(gc, "a key made"), string(gc, " of two parts"));
+    assert(owl_dict_get(gc, dict, lookup)->number == 1.0);
+    assert(owl_dict_remove(gc, dict, owl_rope_concat(gc, string(gc, "a key made of two"), string(gc, " parts"))) == T);
+    assert(dict->dict_length == 0);
+}
+
+static void test_intrinsic(Owl_GC *gc) {
+    Owl_Stack stack = {0};
+    owl_stack_push(&stack, OWL_VALUE_OBJECT(string(gc, "the answer is ")), gc->alloc);
+    owl_stack_push(&stack, owl_value_number(42.0), gc->alloc);
+    owl_stack_push(&stack, OWL_VALUE_OBJECT(string(gc, ", or so they say")), gc->alloc);
+    owl_intrinsic_concat(gc, &stack);
+    assert(stack.length == 4);
+    Owl_Object *result = owl_rope_flatten(gc, OWL_VALUE_AS_OBJECT(stack.data[3]));
+    assert_flat(result, "the answer is 42, or so they say");
+
+    stack.length = 0;
+    owl_intrinsic_concat(gc, &stack);
+    assert_flat(OWL_VALUE_AS_OBJECT(stack.data[0]), "");
+    OWL_DEL(gc->alloc, stack.data);
+}
+
+int main(void) {
+    Owl_GC gc = owl_gc_init(owl_default_alloc_init());
+    test_small(&gc);
+    test_append(&gc);
+    test_prepend(&gc);
+    test_keys(&gc);
+    test_intrinsic(&gc);
+    owl_gc_deinit(&gc);
+    return 0;
+}
@@ -14,7 +14,7 @@ static Owl_String make_const(const char *text) {
 
 static void assert_string(Owl_String string, const char *expected, Owl_Alloc alloc) {
     assert(string.length == strlen(expected));
-    assert(strcmp(string.data, expected) == 0);
+    assert(strcmp(owl_string_data(&string), expected) == 0);
     owl_string_del(&string, alloc);
 }
 
@@ -41,5 +41,43 @@ int main(void) {
     owl_string_add_line_cstr(&lines, "two", alloc);
     assert_string(lines, "one\ntwo\n", alloc);
 
+    // Appends grow the buffer geometrically and fill it in place
+    Owl_String grown = owl_string_new(alloc);
+    size_t reallocations = 0;
+    for (int i = 0; i < 100000; i++) {
+        const char *before = owl_string_data(&grown);
+        owl_string_append_cstr(&grown, "ab", alloc);
+        reallocations += (owl_string_data(&grown) != before);
+    }
+    assert(grown.length == 200000 && grown.capacity >= grown.length);
+    assert(reallocations < 20);
+    assert(grown.data[grown.length] == '\0');
+    owl_string_shrink(&grown, alloc);
+    assert(grown.capacity == grown.length && strncmp(grown.data + 199998, "ab", 3) == 0);
+    owl_string_del(&grown, alloc);
+
+    // A string may be appended to itself
+    Owl_String twice = make_const("abc");
+    owl_string_append(&twice, twice, alloc);
+    owl_string_append(&twice, twice, alloc);
+    assert_string(twice, "abcabcabcabc", alloc);
+
+    Owl_String reserved = make_const("xyz");
+    owl_string_reserve(&reserved, 64, alloc);
+    assert(reserved.owned && reserved.capacity == 64);
+    const char *data = reserved.data;
+    for (int i = 0; i < 61; i++) {
+        owl_string_append_cstr(&reserved, ".", alloc);
+    }
+    assert(reserved.data == data && reserved.length == 64);
+    owl_string_reserve(&reserved, 10, alloc);
+    assert(reserved.data == data);
+    owl_string_del(&reserved, alloc);
+
+    // Borrowed strings stay borrowed until they're written to
+    Owl_String borrowed = make_const("view");
+    owl_string_shrink(&borrowed, alloc);
+    assert(!borrowed.owned && borrowed.capacity == 0);
+
     return 0;
 }
@@ -0,0 +1,108 @@
+#include <assert.h>
+#include <string.h>
+
+#include "gc.h"
+#include "intrinsics.h"
+#include "vector.h"
+
+static void test_kernels(const Owl_VectorIsa isa) {
+    if (owl_vector_use(isa) == F) return;
+    assert(owl_vector_isa() == isa);
+
+    // Odd lengths leave a tail for the scalar loop
+    enum { LENGTH = 1027 };
+    static double a[LENGTH], b[LENGTH], out[LENGTH];
+    for (size_t i = 0; i < LENGTH; i++) {
+        a[i] = (double)i;
+        b[i] = (double)(i % 7) + 1.0;
+    }
+    for (int op = OWL_VECTOR_ADD; op <= OWL_VECTOR_DIV; op++) {
+        owl_vector_op((Owl_VectorOp)op, out, a, b, LENGTH);
+        for (size_t i = 0; i < LENGTH; i++) {
+            assert(out[i] == owl_vector_apply((Owl_VectorOp)op, a[i], b[i]));
+        }
+        owl_vector_op_scalar((Owl_VectorOp)op, out, a, 3.0, LENGTH);
+        for (size_t i = 0; i < LENGTH; i++) {
+            assert(out[i] == owl_vector_apply((Owl_VectorOp)op, a[i], 3.0));
+        }
+        owl_vector_scalar_op((Owl_VectorOp)op, out, 3.0, b, LENGTH);
+        for (size_t i = 0; i < LENGTH; i++) {
+            assert(out[i] == owl_vector_apply((Owl_VectorOp)op, 3.0, b[i]));
+        }
+    }
+
+    // The output may alias an input
+    memcpy(out, a, sizeof(a));
+    owl_vector_op(OWL_VECTOR_MUL, out, out, out, 5);
+    assert(out[4] == 16.0);
+}
+
+static Owl_Value call(Owl_GC *gc, const owl_intrinsic intrinsic, const Owl_Value *args, const size_t count) {
+    Owl_Stack stack = {0};
+    for (size_t i = 0; i < count; i++) {
+        owl_stack_push(&stack, args[i], gc->alloc);
+    }
+    intrinsic(gc, &stack);
+    assert(stack.length == count + 1);
+    const Owl_Value result = stack.data[count];
+    OWL_DEL(gc->alloc, stack.data);
+    return result;
+}
+
+static void test_intrinsics(Owl_GC *gc) {
+    const Owl_Value numbers[] = {owl_value_number(12.0), owl_value_number(3.0), owl_value_number(2.0)};
+    assert(owl_value_as_number(call(gc, owl_intrinsic_add, numbers, 3)) == 17.0);
+    assert(owl_value_as_number(call(gc, owl_intrinsic_sub, numbers, 3)) == 7.0);
+    assert(owl_value_as_number(call(gc, owl_intrinsic_mul, numbers, 3)) == 72.0);
+    assert(owl_value_as_number(call(gc, owl_intrinsic_div, numbers, 3)) == 2.0);
+    assert(owl_value_as_number(call(gc, owl_intrinsic_sub, numbers, 1)) == -12.0);
+    assert(owl_value_as_number(call(gc, owl_intrinsic_div, numbers + 2, 1)) == 0.5);
+    assert(owl_value_as_number(call(gc, owl_intrinsic_mul, numbers, 0)) == 1.0);
+
+    Owl_Object *x = owl_new_f64_array(gc, 1000000);
+    Owl_Object *y = owl_new_f64_array(gc, 1000000);
+    for (size_t i = 0; i < x->f64_length; i++) {
+        x->f64[i] = (double)i;
+        y->f64[i] = 2.0;
+    }
+
+    // (- 1 x y) broadcasts the number and leaves both inputs alone
+    const Owl_Value args[] = {owl_value_number(1.0), OWL_VALUE_OBJECT(x), OWL_VALUE_OBJECT(y)};
+    Owl_Object *result = OWL_VALUE_AS_OBJECT(call(gc, owl_intrinsic_sub, args, 3));
+    assert(OWL_TYPE(result) == OWL_F64_ARRAY && result->f64_length == 1000000);
+    assert(result->f64[0] == -1.0 && result->f64[999999] == -1000000.0);
+    assert(x->f64[10] == 10.0 && y->f64[10] == 2.0);
+
+    const Owl_Value scaled[] = {OWL_VALUE_OBJECT(x), OWL_VALUE_OBJECT(y), owl_value_number(4.0)};
+    result = OWL_VALUE_AS_OBJECT(call(gc, owl_intrinsic_div, scaled, 3));
+    assert(result != x && result->f64[8] == 1.0);
+    result = OWL_VALUE_AS_OBJECT(call(gc, owl_intrinsic_mul, scaled, 2));
+    assert(result->f64[3] == 6.0);
+    result = OWL_VALUE_AS_OBJECT(call(gc, owl_intrinsic_sub, scaled + 1, 1));
+    assert(result->f64[0] == -2.0);
+
+    Owl_Object *small = owl_new_f64_array(gc, 3);
+    small->f64[1] = 1.5;
+    Owl_String string = owl_object_tostring(small, gc->alloc);
+    assert(string.length == 13 && strncmp(owl_string_data(&string), "#f64[0 1.5 0]", string.length) == 0);
+    owl_string_del(&string, gc->alloc);
+
+    // Element storage is released with the array, in the nursery or not
+    owl_gc_add_root(gc, small);
+    owl_gc_mark(gc);
+    owl_gc_sweep(gc);
+    owl_gc_finish_sweep(gc);
+    assert(small->f64[1] == 1.5);
+    owl_gc_remove_root(gc, small);
+}
+
+int main(void) {
+    test_kernels(OWL_VECTOR_GENERIC);
+    test_kernels(OWL_VECTOR_SSE2);
+    test_kernels(OWL_VECTOR_AVX);
+
+    Owl_GC gc = owl_gc_init(owl_default_alloc_init());
+    test_intrinsics(&gc);
+    owl_gc_deinit(&gc);
+    return 0;
+}
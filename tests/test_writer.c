@@ -0,0 +1,157 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "code.h"
+#include "gc.h"
+#include "rope.h"
+
+// Counts what it's handed and keeps the last bytes around
+struct Counter {
+    size_t calls;
+    size_t parts;
+    size_t bytes;
+    char tail[8];
+};
+
+static int count_write(void *state, const struct iovec *parts, int count) {
+    struct Counter *counter = state;
+    counter->calls++;
+    for (int i = 0; i < count; i++) {
+        counter->parts++;
+        counter->bytes += parts[i].iov_len;
+        if (parts[i].iov_len >= sizeof(counter->tail)) {
+            memcpy(counter->tail, (char *)parts[i].iov_base + parts[i].iov_len - sizeof(counter->tail), sizeof(counter->tail));
+        }
+    }
+    return 1;
+}
+
+static int fail_write(void *state, const struct iovec *parts, int count) {
+    (void)parts;
+    (void)count;
+    (*(size_t *)state)++;
+    return 0;
+}
+
+static void test_buffering(void) {
+    char buffer[64];
+    struct Counter counter = {0};
+    Owl_Writer writer = owl_writer_init((Owl_WriterSink){.state = &counter, .write = count_write}, buffer, sizeof(buffer), owl_default_alloc_init());
+
+    // Small writes only reach the sink as full buffers
+    for (int i = 0; i < 100; i++) {
+        owl_writer_write_cstr(&writer, "abc");
+    }
+    assert(counter.calls == 300 / 64 && counter.bytes == counter.calls * 64);
+    assert(owl_writer_flush(&writer));
+    assert(counter.bytes == 300);
+
+    // A large write goes out in the same call as what was buffered
+    char large[1000];
+    memset(large, 'x', sizeof(large));
+    const size_t calls = counter.calls;
+    owl_writer_write_cstr(&writer, "head");
+    owl_writer_write(&writer, large, sizeof(large));
+    assert(counter.calls == calls + 1 && counter.parts == calls + 2);
+    assert(counter.bytes == 1304 && writer.length == 0);
+
+    size_t failures = 0;
+    writer = owl_writer_init((Owl_WriterSink){.state = &failures, .write = fail_write}, buffer, sizeof(buffer), owl_default_alloc_init());
+    owl_writer_write(&writer, large, sizeof(large));
+    owl_writer_write(&writer, large, sizeof(large));
+    assert(!owl_writer_flush(&writer) && failures == 1);
+}
+
+static void test_sinks(Owl_GC *gc) {
+    Owl_Object *list = owl_new_list(gc);
+    for (int i = 0; i < 10000; i++) {
+        owl_list_append(gc, list, owl_new_number(gc, (double)i));
+    }
+    Owl_String expected = owl_object_tostring(list, gc->alloc);
+    char buffer[OWL_WRITER_BUFFER];
+    char *read = OWL_NEW(gc->alloc, expected.length);
+
+    FILE *file = tmpfile();
+    Owl_Writer writer = owl_writer_init(owl_fd_sink(fileno(file)), buffer, sizeof(buffer), gc->alloc);
+    owl_object_write(&writer, list);
+    assert(owl_writer_flush(&writer));
+    rewind(file);
+    assert(fread(read, 1, expected.length, file) == expected.length && fgetc(file) == EOF);
+    assert(memcmp(read, owl_string_data(&expected), expected.length) == 0);
+    fclose(file);
+
+    file = tmpfile();
+    writer = owl_writer_init(owl_file_sink(file), buffer, 100, gc->alloc);
+    owl_object_write(&writer, list);
+    assert(owl_writer_flush(&writer));
+    rewind(file);
+    assert(fread(read, 1, expected.length, file) == expected.length);
+    assert(memcmp(read, owl_string_data(&expected), expected.length) == 0);
+    fclose(file);
+
+    OWL_DEL(gc->alloc, read);
+    owl_string_del(&expected, gc->alloc);
+}
+
+static void test_large(Owl_GC *gc) {
+    // A million elements go out in full buffers without building the text
+    Owl_ListBuilder builder = owl_list_builder(gc);
+    for (size_t i = 0; i < 1000000; i++) {
+        owl_list_builder_append(gc, &builder, owl_new_number(gc, (double)(i % 10)));
+    }
+    char buffer[4096];
+    struct Counter counter = {0};
+    Owl_Writer writer = owl_writer_init((Owl_WriterSink){.state = &counter, .write = count_write}, buffer, sizeof(buffer), gc->alloc);
+    owl_object_write(&writer, builder.head);
+    assert(owl_writer_flush(&writer));
+    assert(counter.bytes == 2000001);
+    assert(counter.calls == (counter.bytes + sizeof(buffer) - 1) / sizeof(buffer));
+    assert(memcmp(counter.tail, "6 7 8 9)", 8) == 0);
+
+    // Ropes are written piece by piece
+    Owl_Object *rope = owl_new_string(gc, "", 0);
+    for (int i = 0; i < 1000; i++) {
+        rope = owl_rope_concat(gc, rope, owl_new_string(gc, "0123456789", 10));
+    }
+    Owl_StringSink target = {.string = owl_string_new(gc->alloc), .alloc = gc->alloc};
+    writer = owl_writer_init(owl_string_sink(&target), buffer, sizeof(buffer), gc->alloc);
+    owl_object_write(&writer, rope);
+    owl_writer_flush(&writer);
+    assert(target.string.length == 10002);
+    assert(strncmp(owl_string_data(&target.string), "\"01234567890123", 15) == 0);
+    owl_string_del(&target.string, gc->alloc);
+}
+
+static void test_code(Owl_GC *gc) {
+    Owl_Code code = owl_code_init(gc->alloc);
+    owl_code_push(&code, owl_value_number(1.5));
+    owl_code_push(&code, OWL_VALUE_TRUE);
+    owl_code_syscall(&code, NULL, "+", 2);
+
+    char buffer[8];
+    Owl_StringSink target = {.string = owl_string_new(gc->alloc), .alloc = gc->alloc};
+    Owl_Writer writer = owl_writer_init(owl_string_sink(&target), buffer, sizeof(buffer), gc->alloc);
+    owl_code_write(&writer, &code);
+    owl_writer_flush(&writer);
+
+    Owl_String listing = owl_code_tostr(&code);
+    const char *expected = "PUSH 1.5\nPUSH #t\nSYSCALL + argc=2\n";
+    assert(target.string.length == strlen(expected) && strcmp(owl_string_data(&target.string), expected) == 0);
+    assert(listing.length == strlen(expected) && strcmp(owl_string_data(&listing), expected) == 0);
+    owl_string_del(&target.string, gc->alloc);
+    owl_string_del(&listing, gc->alloc);
+    owl_code_deinit(&code);
+}
+
+int main(void) {
+    test_buffering();
+
+    Owl_GC gc = owl_gc_init(owl_default_alloc_init());
+    test_sinks(&gc);
+    test_large(&gc);
+    test_code(&gc);
+    owl_gc_deinit(&gc);
+    return 0;
+}
@@ -0,0 +1,79 @@
+#ifndef OWL_VALUE_H
+#define OWL_VALUE_H
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+struct Owl_Object;
+
+// Values are NaN-boxed into 64 bits. Anything that isn't a quiet NaN with
+// the top mantissa bits set is a double, the low bits of those NaNs tag
+// nothing and the booleans, and with the sign bit set they hold a pointer
+// to a heap object.
+typedef uint64_t Owl_Value;
+
+#define OWL_VALUE_QNAN \
+    ((uint64_t)0x7ffc000000000000)
+
+#define OWL_VALUE_SIGN_BIT \
+    ((uint64_t)0x8000000000000000)
+
+#define OWL_VALUE_TAG_NOTHING \
+    1
+
+#define OWL_VALUE_TAG_FALSE \
+    2
+
+#define OWL_VALUE_TAG_TRUE \
+    3
+
+#define OWL_VALUE_NOTHING \
+    ((Owl_Value)(OWL_VALUE_QNAN | OWL_VALUE_TAG_NOTHING))
+
+#define OWL_VALUE_FALSE \
+    ((Owl_Value)(OWL_VALUE_QNAN | OWL_VALUE_TAG_FALSE))
+
+#define OWL_VALUE_TRUE \
+    ((Owl_Value)(OWL_VALUE_QNAN | OWL_VALUE_TAG_TRUE))
+
+#define OWL_VALUE_BOOLEAN(b) \
+    ((b) ? OWL_VALUE_TRUE : OWL_VALUE_FALSE)
+
+#define OWL_VALUE_OBJECT(o) \
+    ((Owl_Value)(OWL_VALUE_SIGN_BIT | OWL_VALUE_QNAN | (uint64_t)(uintptr_t)(o)))
+
+#define OWL_VALUE_IS_NUMBER(v) \
+    (((v) & OWL_VALUE_QNAN) != OWL_VALUE_QNAN)
+
+#define OWL_VALUE_IS_NOTHING(v) \
+    ((v) == OWL_VALUE_NOTHING)
+
+#define OWL_VALUE_IS_BOOLEAN(v) \
+    (((v) | 1) == OWL_VALUE_TRUE)
+
+#define OWL_VALUE_IS_OBJECT(v) \
+    (((v) & (OWL_VALUE_QNAN | OWL_VALUE_SIGN_BIT)) == (OWL_VALUE_QNAN | OWL_VALUE_SIGN_BIT))
+
+#define OWL_VALUE_AS_BOOLEAN(v) \
+    ((v) == OWL_VALUE_TRUE)
+
+#define OWL_VALUE_AS_OBJECT(v) \
+    ((struct Owl_Object *)(uintptr_t)((v) & ~(OWL_VALUE_SIGN_BIT | OWL_VALUE_QNAN)))
+
+static inline Owl_Value owl_value_number(double number) {
+    // Keep NaNs produced by arithmetic from aliasing a tagged value
+    if (number != number) {
+        number = NAN;
+    }
+    Owl_Value value;
+    memcpy(&value, &number, sizeof(value));
+    return value;
+}
+
+static inline double owl_value_as_number(const Owl_Value value) {
+    double number;
+    memcpy(&number, &value, sizeof(number));
+    return number;
+}
+
+#endif //OWL_VALUE_H
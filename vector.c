@@ -0,0 +1,182 @@
+#include "vector.h"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define OWL_VECTOR_X86 1
+#endif
+
+typedef void (*owl_vector_kernel)(double *out, const double *a, const double *b, size_t length);
+
+// One kernel per operation for each operand shape: both arrays, array and
+// scalar, scalar and array. Scalars are passed by pointer.
+struct Owl_VectorKernels {
+    Owl_VectorIsa isa;
+    owl_vector_kernel vv[OWL_VECTOR_OP_COUNT];
+    owl_vector_kernel vs[OWL_VECTOR_OP_COUNT];
+    owl_vector_kernel sv[OWL_VECTOR_OP_COUNT];
+};
+
+typedef struct Owl_VectorKernels Owl_VectorKernels;
+
+#define OWL_VECTOR_GENERIC_KERNELS(name, operator) \
+    static void owl_vector_##name##_vv_generic(double *out, const double *a, const double *b, const size_t length) { \
+        for (size_t i = 0; i < length; i++) { \
+            out[i] = a[i] operator b[i]; \
+        } \
+    } \
+    static void owl_vector_##name##_vs_generic(double *out, const double *a, const double *b, const size_t length) { \
+        const double scalar = *b; \
+        for (size_t i = 0; i < length; i++) { \
+            out[i] = a[i] operator scalar; \
+        } \
+    } \
+    static void owl_vector_##name##_sv_generic(double *out, const double *a, const double *b, const size_t length) { \
+        const double scalar = *a; \
+        for (size_t i = 0; i < length; i++) { \
+            out[i] = scalar operator b[i]; \
+        } \
+    }
+
+// The SIMD loops handle width elements at a time and leave the remainder
+// to a scalar tail. Unaligned loads, since element storage comes from the
+// GC's allocator.
+#define OWL_VECTOR_SIMD_KERNELS(isa, feature, type, width, load, store, broadcast, intrinsic, name, operator) \
+    __attribute__((target(feature))) \
+    static void owl_vector_##name##_vv_##isa(double *out, const double *a, const double *b, const size_t length) { \
+        size_t i = 0; \
+        for (; i + (width) <= length; i += (width)) { \
+            store(out + i, intrinsic(load(a + i), load(b + i))); \
+        } \
+        for (; i < length; i++) { \
+            out[i] = a[i] operator b[i]; \
+        } \
+    } \
+    __attribute__((target(feature))) \
+    static void owl_vector_##name##_vs_##isa(double *out, const double *a, const double *b, const size_t length) { \
+        const double scalar = *b; \
+        const type vector = broadcast(scalar); \
+        size_t i = 0; \
+        for (; i + (width) <= length; i += (width)) { \
+            store(out + i, intrinsic(load(a + i), vector)); \
+        } \
+        for (; i < length; i++) { \
+            out[i] = a[i] operator scalar; \
+        } \
+    } \
+    __attribute__((target(feature))) \
+    static void owl_vector_##name##_sv_##isa(double *out, const double *a, const double *b, const size_t length) { \
+        const double scalar = *a; \
+        const type vector = broadcast(scalar); \
+        size_t i = 0; \
+        for (; i + (width) <= length; i += (width)) { \
+            store(out + i, intrinsic(vector, load(b + i))); \
+        } \
+        for (; i < length; i++) { \
+            out[i] = scalar operator b[i]; \
+        } \
+    }
+
+#define OWL_VECTOR_TABLE(tag, suffix) \
+    { \
+        .isa = tag, \
+        .vv = {owl_vector_add_vv_##suffix, owl_vector_sub_vv_##suffix, owl_vector_mul_vv_##suffix, owl_vector_div_vv_##suffix}, \
+        .vs = {owl_vector_add_vs_##suffix, owl_vector_sub_vs_##suffix, owl_vector_mul_vs_##suffix, owl_vector_div_vs_##suffix}, \
+        .sv = {owl_vector_add_sv_##suffix, owl_vector_sub_sv_##suffix, owl_vector_mul_sv_##suffix, owl_vector_div_sv_##suffix}, \
+    }
+
+OWL_VECTOR_GENERIC_KERNELS(add, +)
+OWL_VECTOR_GENERIC_KERNELS(sub, -)
+OWL_VECTOR_GENERIC_KERNELS(mul, *)
+OWL_VECTOR_GENERIC_KERNELS(div, /)
+
+static const Owl_VectorKernels owl_vector_generic = OWL_VECTOR_TABLE(OWL_VECTOR_GENERIC, generic);
+
+#ifdef OWL_VECTOR_X86
+OWL_VECTOR_SIMD_KERNELS(sse2, "sse2", __m128d, 2, _mm_loadu_pd, _mm_storeu_pd, _mm_set1_pd, _mm_add_pd, add, +)
+OWL_VECTOR_SIMD_KERNELS(sse2, "sse2", __m128d, 2, _mm_loadu_pd, _mm_storeu_pd, _mm_set1_pd, _mm_sub_pd, sub, -)
+OWL_VECTOR_SIMD_KERNELS(sse2, "sse2", __m128d, 2, _mm_loadu_pd, _mm_storeu_pd, _mm_set1_pd, _mm_mul_pd, mul, *)
+OWL_VECTOR_SIMD_KERNELS(sse2, "sse2", __m128d, 2, _mm_loadu_pd, _mm_storeu_pd, _mm_set1_pd, _mm_div_pd, div, /)
+
+OWL_VECTOR_SIMD_KERNELS(avx, "avx", __m256d, 4, _mm256_loadu_pd, _mm256_storeu_pd, _mm256_set1_pd, _mm256_add_pd, add, +)
+OWL_VECTOR_SIMD_KERNELS(avx, "avx", __m256d, 4, _mm256_loadu_pd, _mm256_storeu_pd, _mm256_set1_pd, _mm256_sub_pd, sub, -)
+OWL_VECTOR_SIMD_KERNELS(avx, "avx", __m256d, 4, _mm256_loadu_pd, _mm256_storeu_pd, _mm256_set1_pd, _mm256_mul_pd, mul, *)
+OWL_VECTOR_SIMD_KERNELS(avx, "avx", __m256d, 4, _mm256_loadu_pd, _mm256_storeu_pd, _mm256_set1_pd, _mm256_div_pd, div, /)
+
+static const Owl_VectorKernels owl_vector_sse2 = OWL_VECTOR_TABLE(OWL_VECTOR_SSE2, sse2);
+static const Owl_VectorKernels owl_vector_avx = OWL_VECTOR_TABLE(OWL_VECTOR_AVX, avx);
+#endif
+
+// Selected once, racing threads all store the same table
+static const Owl_VectorKernels *owl_vector_selected = NULL;
+
+static const Owl_VectorKernels *owl_vector_kernels_for(const Owl_VectorIsa isa) {
+    switch (isa) {
+#ifdef OWL_VECTOR_X86
+        case OWL_VECTOR_AVX:
+            __builtin_cpu_init();
+            return (__builtin_cpu_supports("avx") ? &owl_vector_avx : NULL);
+        case OWL_VECTOR_SSE2:
+            // Part of the x86-64 baseline
+            return &owl_vector_sse2;
+#endif
+        case OWL_VECTOR_GENERIC:
+            return &owl_vector_generic;
+        default:
+            return NULL;
+    }
+}
+
+static const Owl_VectorKernels *owl_vector_kernels(void) {
+    const Owl_VectorKernels *kernels = __atomic_load_n(&owl_vector_selected, __ATOMIC_ACQUIRE);
+    if (kernels != NULL) {
+        return kernels;
+    }
+    kernels = owl_vector_kernels_for(OWL_VECTOR_AVX);
+    if (kernels == NULL) {
+        kernels = owl_vector_kernels_for(OWL_VECTOR_SSE2);
+    }
+    if (kernels == NULL) {
+        kernels = &owl_vector_generic;
+    }
+    __atomic_store_n(&owl_vector_selected, kernels, __ATOMIC_RELEASE);
+    return kernels;
+}
+
+Owl_VectorIsa owl_vector_isa(void) {
+    return owl_vector_kernels()->isa;
+}
+
+Owl_Boolean owl_vector_use(const Owl_VectorIsa isa) {
+    const Owl_VectorKernels *kernels = owl_vector_kernels_for(isa);
+    if (kernels == NULL) {
+        return F;
+    }
+    __atomic_store_n(&owl_vector_selected, kernels, __ATOMIC_RELEASE);
+    return T;
+}
+
+double owl_vector_apply(const Owl_VectorOp op, const double a, const double b) {
+    switch (op) {
+        case OWL_VECTOR_ADD:
+            return a + b;
+        case OWL_VECTOR_SUB:
+            return a - b;
+        case OWL_VECTOR_MUL:
+            return a * b;
+        case OWL_VECTOR_DIV:
+            return a / b;
+    }
+    return 0.0;
+}
+
+void owl_vector_op(const Owl_VectorOp op, double *out, const double *a, const double *b, const size_t length) {
+    owl_vector_kernels()->vv[op](out, a, b, length);
+}
+
+void owl_vector_op_scalar(const Owl_VectorOp op, double *out, const double *a, const double b, const size_t length) {
+    owl_vector_kernels()->vs[op](out, a, &b, length);
+}
+
+void owl_vector_scalar_op(const Owl_VectorOp op, double *out, const double a, const double *b, const size_t length) {
+    owl_vector_kernels()->sv[op](out, &a, b, length);
+}
@@ -0,0 +1,45 @@
+#ifndef OWL_VECTOR_H
+#define OWL_VECTOR_H
+#include <stddef.h>
+
+#include "objects.h"
+
+// Element-wise arithmetic over arrays of doubles. The kernels are picked
+// the first time one is called, AVX when the CPU has it, SSE2 on other
+// x86-64 machines and plain loops everywhere else.
+enum Owl_VectorOp {
+    OWL_VECTOR_ADD,
+    OWL_VECTOR_SUB,
+    OWL_VECTOR_MUL,
+    OWL_VECTOR_DIV
+};
+
+typedef enum Owl_VectorOp Owl_VectorOp;
+
+#define OWL_VECTOR_OP_COUNT \
+    (OWL_VECTOR_DIV + 1)
+
+enum Owl_VectorIsa {
+    OWL_VECTOR_GENERIC,
+    OWL_VECTOR_SSE2,
+    OWL_VECTOR_AVX
+};
+
+typedef enum Owl_VectorIsa Owl_VectorIsa;
+
+Owl_VectorIsa owl_vector_isa(void);
+
+// Switches to the kernels for isa, returns F if this CPU can't run them
+Owl_Boolean owl_vector_use(Owl_VectorIsa isa);
+
+double owl_vector_apply(Owl_VectorOp op, double a, double b);
+
+// out may be the same array as a or b in all three
+// out[i] = a[i] op b[i]
+void owl_vector_op(Owl_VectorOp op, double *out, const double *a, const double *b, size_t length);
+// out[i] = a[i] op b
+void owl_vector_op_scalar(Owl_VectorOp op, double *out, const double *a, double b, size_t length);
+// out[i] = a op b[i]
+void owl_vector_scalar_op(Owl_VectorOp op, double *out, double a, const double *b, size_t length);
+
+#endif //OWL_VECTOR_H
@@ -0,0 +1,127 @@
+#include "writer.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+Owl_Writer owl_writer_init(const Owl_WriterSink sink, char *buffer, const size_t capacity, const Owl_Alloc alloc) {
+    Owl_Writer writer = {
+        .sink = sink,
+        .buffer = buffer,
+        .capacity = capacity,
+        .length = 0,
+        .alloc = alloc,
+        .failed = 0,
+    };
+    return writer;
+}
+
+static void owl_writer_send(Owl_Writer *writer, const char *data, const size_t length) {
+    struct iovec parts[2];
+    int count = 0;
+    if (writer->length > 0) {
+        parts[count++] = (struct iovec){.iov_base = writer->buffer, .iov_len = writer->length};
+    }
+    if (length > 0) {
+        parts[count++] = (struct iovec){.iov_base = (void *)data, .iov_len = length};
+    }
+    writer->length = 0;
+    if (count == 0 || writer->failed) {
+        return;
+    }
+    if (!writer->sink.write(writer->sink.state, parts, count)) {
+        writer->failed = 1;
+    }
+}
+
+void owl_writer_write(Owl_Writer *writer, const char *data, size_t length) {
+    if (length == 0) {
+        return;
+    }
+    const size_t space = writer->capacity - writer->length;
+    if (length <= space) {
+        memcpy(writer->buffer + writer->length, data, length);
+        writer->length += length;
+        return;
+    }
+    if (length >= writer->capacity) {
+        owl_writer_send(writer, data, length);
+        return;
+    }
+
+    // Top the buffer up so every flush is a full one
+    memcpy(writer->buffer + writer->length, data, space);
+    writer->length = writer->capacity;
+    owl_writer_send(writer, NULL, 0);
+    memcpy(writer->buffer, data + space, length - space);
+    writer->length = length - space;
+}
+
+void owl_writer_write_cstr(Owl_Writer *writer, const char *text) {
+    owl_writer_write(writer, text, strlen(text));
+}
+
+void owl_writer_write_string(Owl_Writer *writer, Owl_String string) {
+    owl_writer_write(writer, owl_string_data(&string), string.length);
+}
+
+int owl_writer_flush(Owl_Writer *writer) {
+    owl_writer_send(writer, NULL, 0);
+    return !writer->failed;
+}
+
+static int owl_fd_sink_write(void *state, const struct iovec *parts, int count) {
+    const int fd = (int)(intptr_t)state;
+    struct iovec pending[2];
+    memcpy(pending, parts, sizeof(struct iovec) * (size_t)count);
+
+    struct iovec *part = pending;
+    while (count > 0) {
+        ssize_t written = writev(fd, part, count);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return 0;
+        }
+        while (count > 0 && (size_t)written >= part->iov_len) {
+            written -= (ssize_t)part->iov_len;
+            part++;
+            count--;
+        }
+        if (count > 0) {
+            part->iov_base = (char *)part->iov_base + written;
+            part->iov_len -= (size_t)written;
+        }
+    }
+    return 1;
+}
+
+Owl_WriterSink owl_fd_sink(const int fd) {
+    return (Owl_WriterSink){.state = (void *)(intptr_t)fd, .write = owl_fd_sink_write};
+}
+
+static int owl_file_sink_write(void *state, const struct iovec *parts, int count) {
+    FILE *file = state;
+    for (int i = 0; i < count; i++) {
+        if (fwrite(parts[i].iov_base, 1, parts[i].iov_len, file) != parts[i].iov_len) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+Owl_WriterSink owl_file_sink(FILE *file) {
+    return (Owl_WriterSink){.state = file, .write = owl_file_sink_write};
+}
+
+static int owl_string_sink_write(void *state, const struct iovec *parts, int count) {
+    Owl_StringSink *target = state;
+    for (int i = 0; i < count; i++) {
+        owl_string_append(&target->string, (Owl_String){.data = parts[i].iov_base, .length = parts[i].iov_len}, target->alloc);
+    }
+    return 1;
+}
+
+Owl_WriterSink owl_string_sink(Owl_StringSink *target) {
+    return (Owl_WriterSink){.state = target, .write = owl_string_sink_write};
+}
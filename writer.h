@@ -0,0 +1,64 @@
+#ifndef OWL_WRITER_H
+#define OWL_WRITER_H
+#include <stddef.h>
+#include <stdio.h>
+#include <sys/uio.h>
+
+#include "alloc.h"
+#include "strings.h"
+
+// Buffer size for writers going to a file or descriptor
+#define OWL_WRITER_BUFFER \
+    (64 * 1024)
+
+// Receives the parts in order, at most two of them: what was buffered and
+// a write too large to be worth copying. Returns zero on failure.
+struct Owl_WriterSink {
+    void *state;
+
+    int (*write)(void *state, const struct iovec *parts, int count);
+};
+
+typedef struct Owl_WriterSink Owl_WriterSink;
+
+// Collects output into a fixed buffer supplied by the caller and hands it
+// to the sink whenever the buffer fills up. Large writes bypass the
+// buffer and go out together with it in one call. The allocator is only
+// used for scratch space while walking deep structures.
+struct Owl_Writer {
+    Owl_WriterSink sink;
+    char *buffer;
+    size_t capacity;
+    size_t length;
+    Owl_Alloc alloc;
+    // Set once the sink fails, later writes are dropped
+    int failed;
+};
+
+typedef struct Owl_Writer Owl_Writer;
+
+Owl_Writer owl_writer_init(Owl_WriterSink sink, char *buffer, size_t capacity, Owl_Alloc alloc);
+
+void owl_writer_write(Owl_Writer *writer, const char *data, size_t length);
+void owl_writer_write_cstr(Owl_Writer *writer, const char *text);
+void owl_writer_write_string(Owl_Writer *writer, Owl_String string);
+
+// Hands anything buffered to the sink, returns zero if any write failed
+int owl_writer_flush(Owl_Writer *writer);
+
+// Writes with writev, retrying partial writes and interruptions
+Owl_WriterSink owl_fd_sink(int fd);
+
+Owl_WriterSink owl_file_sink(FILE *file);
+
+struct Owl_StringSink {
+    Owl_String string;
+    Owl_Alloc alloc;
+};
+
+typedef struct Owl_StringSink Owl_StringSink;
+
+// Appends to target->string, which the caller owns
+Owl_WriterSink owl_string_sink(Owl_StringSink *target);
+
+#endif //OWL_WRITER_H